@@ -0,0 +1,221 @@
+// ProfiledMutex.h
+// Mutex that can record its own contention. Built with
+// CSOPESY_LOCK_PROFILING defined, every ProfiledMutex counts acquisitions
+// and contended acquisitions (try_lock failed first) and keeps power-of-two
+// histograms of the wait for a contended lock and of the time it was held.
+// Mutexes constructed with the same name share one profile, so every
+// TSQueue shows up as a single "TSQueue::m_mutex" line.
+//
+// Without the define, ProfiledMutex is a std::mutex that ignores its name,
+// and ProfiledCondition / ProfiledUniqueLock are the usual std types.
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef CSOPESY_LOCK_PROFILING
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#endif
+
+// Summary of one lock profile; times in steady-clock nanoseconds, and
+// percentiles reported as the upper end of their power-of-two bucket
+struct LockProfileSummary {
+    std::string name;
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t waitTotal = 0;     // over contended acquisitions
+    uint64_t waitP50 = 0;
+    uint64_t waitP99 = 0;
+    uint64_t waitMax = 0;
+    uint64_t holdTotal = 0;
+    uint64_t holdP50 = 0;
+    uint64_t holdP99 = 0;
+    uint64_t holdMax = 0;
+};
+
+#ifdef CSOPESY_LOCK_PROFILING
+
+inline bool lockProfilingEnabled() { return true; }
+
+// Shared by every mutex with the same name. Updated with relaxed atomics so
+// recording never takes another lock.
+struct LockProfile {
+    static const int Buckets = 65;   // bucket b holds values in [2^(b-1), 2^b)
+
+    std::string name;
+    std::atomic<uint64_t> acquisitions{ 0 };
+    std::atomic<uint64_t> contended{ 0 };
+    std::atomic<uint64_t> waitTotal{ 0 };
+    std::atomic<uint64_t> waitMax{ 0 };
+    std::atomic<uint64_t> holdTotal{ 0 };
+    std::atomic<uint64_t> holdMax{ 0 };
+    std::atomic<uint64_t> waitBuckets[Buckets];
+    std::atomic<uint64_t> holdBuckets[Buckets];
+
+    explicit LockProfile(const std::string& n) : name(n) { reset(); }
+
+    void reset() {
+        acquisitions = 0;
+        contended = 0;
+        waitTotal = 0;
+        waitMax = 0;
+        holdTotal = 0;
+        holdMax = 0;
+        for (auto& b : waitBuckets) b = 0;
+        for (auto& b : holdBuckets) b = 0;
+    }
+
+    static int bucketOf(uint64_t nanos) {
+        int b = 0;
+        while (nanos) {
+            nanos >>= 1;
+            b++;
+        }
+        return b;
+    }
+
+    static void record(std::atomic<uint64_t>* buckets, std::atomic<uint64_t>& total,
+        std::atomic<uint64_t>& max, uint64_t nanos) {
+        buckets[bucketOf(nanos)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(nanos, std::memory_order_relaxed);
+        uint64_t seen = max.load(std::memory_order_relaxed);
+        while (nanos > seen && !max.compare_exchange_weak(seen, nanos, std::memory_order_relaxed)) {}
+    }
+
+    static uint64_t percentile(const std::atomic<uint64_t>* buckets, double fraction, uint64_t max) {
+        uint64_t count = 0;
+        for (int b = 0; b < Buckets; ++b) count += buckets[b].load(std::memory_order_relaxed);
+        if (count == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(fraction * count + 0.5);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < Buckets; ++b) {
+            seen += buckets[b].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                uint64_t upper = b == 0 ? 0 : (b >= 64 ? UINT64_MAX : (1ULL << b) - 1);
+                return upper < max ? upper : max;
+            }
+        }
+        return max;
+    }
+};
+
+// Profiles by name; they live for the whole run so a lock that goes away
+// (a replaced scheduling policy's queue) keeps its numbers
+struct LockProfileRegistry {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<LockProfile>> profiles;
+
+    static LockProfileRegistry& instance() {
+        static LockProfileRegistry registry;
+        return registry;
+    }
+
+    LockProfile& get(const char* name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& slot = profiles[name];
+        if (!slot) slot = std::make_unique<LockProfile>(name);
+        return *slot;
+    }
+};
+
+class ProfiledMutex {
+public:
+    explicit ProfiledMutex(const char* name) : profile_(LockProfileRegistry::instance().get(name)) {}
+    ProfiledMutex(const ProfiledMutex&) = delete;
+    ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+    void lock() {
+        if (!mutex_.try_lock()) {
+            auto start = Clock::now();
+            mutex_.lock();
+            acquiredAt_ = Clock::now();
+            profile_.contended.fetch_add(1, std::memory_order_relaxed);
+            LockProfile::record(profile_.waitBuckets, profile_.waitTotal, profile_.waitMax, nanosBetween(start, acquiredAt_));
+        }
+        else {
+            acquiredAt_ = Clock::now();
+        }
+        profile_.acquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    bool try_lock() {
+        if (!mutex_.try_lock()) return false;
+        acquiredAt_ = Clock::now();
+        profile_.acquisitions.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void unlock() {
+        // Still held here, so acquiredAt_ is ours
+        LockProfile::record(profile_.holdBuckets, profile_.holdTotal, profile_.holdMax,
+            nanosBetween(acquiredAt_, Clock::now()));
+        mutex_.unlock();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static uint64_t nanosBetween(Clock::time_point from, Clock::time_point to) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    }
+
+    std::mutex mutex_;
+    LockProfile& profile_;
+    Clock::time_point acquiredAt_;
+};
+
+using ProfiledCondition = std::condition_variable_any;
+using ProfiledUniqueLock = std::unique_lock<ProfiledMutex>;
+
+inline std::vector<LockProfileSummary> getLockProfiles() {
+    LockProfileRegistry& registry = LockProfileRegistry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<LockProfileSummary> out;
+    for (const auto& entry : registry.profiles) {
+        const LockProfile& p = *entry.second;
+        LockProfileSummary s;
+        s.name = p.name;
+        s.acquisitions = p.acquisitions.load();
+        s.contended = p.contended.load();
+        s.waitTotal = p.waitTotal.load();
+        s.waitMax = p.waitMax.load();
+        s.waitP50 = LockProfile::percentile(p.waitBuckets, 0.50, s.waitMax);
+        s.waitP99 = LockProfile::percentile(p.waitBuckets, 0.99, s.waitMax);
+        s.holdTotal = p.holdTotal.load();
+        s.holdMax = p.holdMax.load();
+        s.holdP50 = LockProfile::percentile(p.holdBuckets, 0.50, s.holdMax);
+        s.holdP99 = LockProfile::percentile(p.holdBuckets, 0.99, s.holdMax);
+        out.push_back(s);
+    }
+    return out;
+}
+
+// Not synchronized with lockers; a sample taken during the reset may land
+// on either side of it
+inline void resetLockProfiles() {
+    LockProfileRegistry& registry = LockProfileRegistry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& entry : registry.profiles) entry.second->reset();
+}
+
+#else
+
+inline bool lockProfilingEnabled() { return false; }
+
+class ProfiledMutex : public std::mutex {
+public:
+    explicit ProfiledMutex(const char*) {}
+};
+
+using ProfiledCondition = std::condition_variable;
+using ProfiledUniqueLock = std::unique_lock<std::mutex>;
+
+inline std::vector<LockProfileSummary> getLockProfiles() { return {}; }
+inline void resetLockProfiles() {}
+
+#endif
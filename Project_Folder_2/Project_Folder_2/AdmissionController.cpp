@@ -0,0 +1,147 @@
+#include "AdmissionController.h"
+#include <algorithm>
+
+AdmissionController::AdmissionController(MemoryManager& memoryManager, uint64_t maxHeadWaitTicks)
+    : memoryManager_(memoryManager), maxHeadWaitTicks_(maxHeadWaitTicks) {}
+
+void AdmissionController::setMaxHeadWait(uint64_t ticks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxHeadWaitTicks_ = ticks;
+}
+
+int AdmissionController::sizeOf(const Process& p) const {
+    return p.getMemorySize() > 0 ? p.getMemorySize() : memoryManager_.getMemPerProc();
+}
+
+bool AdmissionController::tryAllocate(Process& p) {
+    if (!memoryManager_.allocate(p.getPid(), sizeOf(p))) return false;
+    if (p.getMemorySize() <= 0) p.setMemorySize(memoryManager_.getMemPerProc());
+    p.attachMemory(&memoryManager_);
+    p.setInMemory(true);
+    admitted_++;
+    return true;
+}
+
+void AdmissionController::recordWait(uint64_t ticks) {
+    waitTicks_.record(ticks);
+}
+
+bool AdmissionController::submit(std::shared_ptr<Process> p, uint64_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return submitLocked(p, now);
+}
+
+void AdmissionController::submitMany(const std::vector<std::shared_ptr<Process>>& processes,
+    uint64_t now, std::vector<std::shared_ptr<Process>>& admitted) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& p : processes) {
+        if (submitLocked(p, now)) admitted.push_back(p);
+    }
+}
+
+bool AdmissionController::submitLocked(const std::shared_ptr<Process>& p, uint64_t now) {
+    // Only bypass the queue when nobody is waiting, to keep arrivals in order
+    if (pending_ == 0 && tryAllocate(*p)) {
+        recordWait(0);
+        return true;
+    }
+    bySize_[sizeOf(*p)].push_back({ p, nextSeq_++, now });
+    pending_++;
+    pendingBytes_ += sizeOf(*p);
+    return false;
+}
+
+void AdmissionController::admit(uint64_t now, std::vector<std::shared_ptr<Process>>& admitted) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Admit from the head (oldest waiting process) while it fits
+    while (pending_ > 0) {
+        auto head = bySize_.end();
+        for (auto it = bySize_.begin(); it != bySize_.end(); ++it) {
+            if (!it->second.empty() && (head == bySize_.end() || it->second.front().seq < head->second.front().seq))
+                head = it;
+        }
+
+        Entry& e = head->second.front();
+        if (!tryAllocate(*e.process)) {
+            // Head is starving: stop backfilling so memory drains towards it
+            if (now - e.enqueueTick >= maxHeadWaitTicks_) return;
+            break;
+        }
+        recordWait(now - e.enqueueTick);
+        admitted.push_back(e.process);
+        head->second.pop_front();
+        pending_--;
+        pendingBytes_ -= head->first;
+    }
+    if (pending_ == 0) return;
+
+    // Backfill younger processes that fit, smallest size first
+    int largest = memoryManager_.largestFreeBlock();
+    for (auto& kv : bySize_) {
+        if (kv.first > largest) break;  // this and all larger sizes cannot fit
+        auto& queue = kv.second;
+        while (!queue.empty() && kv.first <= largest) {
+            Entry& e = queue.front();
+            if (!tryAllocate(*e.process)) break;
+            recordWait(now - e.enqueueTick);
+            admitted.push_back(e.process);
+            queue.pop_front();
+            pending_--;
+            pendingBytes_ -= kv.first;
+            backfilled_++;
+            largest = memoryManager_.largestFreeBlock();
+        }
+    }
+}
+
+size_t AdmissionController::pendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+}
+
+uint64_t AdmissionController::pendingBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pendingBytes_;
+}
+
+int AdmissionController::smallestPendingSize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& kv : bySize_) {
+        if (!kv.second.empty()) return kv.first;
+    }
+    return 0;
+}
+
+void AdmissionController::getPending(std::vector<std::pair<std::shared_ptr<Process>, uint64_t>>& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<const Entry*> entries;
+    entries.reserve(pending_);
+    for (const auto& kv : bySize_) {
+        for (const auto& e : kv.second) entries.push_back(&e);
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry* a, const Entry* b) { return a->seq < b->seq; });
+    out.reserve(out.size() + entries.size());
+    for (const Entry* e : entries) out.emplace_back(e->process, e->enqueueTick);
+}
+
+void AdmissionController::restorePending(std::shared_ptr<Process> p, uint64_t enqueueTick) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int size = sizeOf(*p);
+    bySize_[size].push_back({ std::move(p), nextSeq_++, enqueueTick });
+    pending_++;
+    pendingBytes_ += size;
+}
+
+AdmissionStats AdmissionController::getStats() const {
+    AdmissionStats stats;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.admitted = admitted_;
+    stats.backfilled = backfilled_;
+    stats.pending = pending_;
+    stats.p50 = waitTicks_.percentile(0.50);
+    stats.p90 = waitTicks_.percentile(0.90);
+    stats.p99 = waitTicks_.percentile(0.99);
+    stats.max = waitTicks_.max();
+    return stats;
+}
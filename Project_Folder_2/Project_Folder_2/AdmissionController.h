@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Process.h"
+#include "MemoryManager.h"
+#include "LatencyHistogram.h"
+
+// Admission wait summary, in CPU ticks; percentiles are within 1/64 of the
+// recorded waits (see LatencyHistogram)
+struct AdmissionStats {
+    uint64_t admitted = 0;
+    uint64_t backfilled = 0;   // admitted ahead of an older waiting process
+    size_t   pending = 0;
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+// Holds processes waiting for memory and admits them with backfilling:
+// when the oldest process does not fit, younger ones that fit are admitted
+// instead, until the oldest has waited maxHeadWaitTicks. After that nothing
+// is backfilled so freed memory goes to the oldest process.
+//
+// Waiting processes are grouped by memory size. Every process in a group
+// needs the same amount, so a group is skipped as a whole when its size is
+// larger than the largest free block; with a single size the pass is O(1).
+class AdmissionController {
+public:
+    AdmissionController(MemoryManager& memoryManager, uint64_t maxHeadWaitTicks);
+
+    void setMaxHeadWait(uint64_t ticks);
+
+    // Admits p right away if nothing is waiting and it fits; otherwise queues it.
+    // Returns true if p was admitted.
+    bool submit(std::shared_ptr<Process> p, uint64_t now);
+
+    // submit() for each process under one lock; the ones admitted right away
+    // are appended to admitted
+    void submitMany(const std::vector<std::shared_ptr<Process>>& processes, uint64_t now,
+        std::vector<std::shared_ptr<Process>>& admitted);
+
+    // Admits every waiting process that can be admitted now, in admission order
+    void admit(uint64_t now, std::vector<std::shared_ptr<Process>>& admitted);
+
+    size_t pendingCount() const;
+    // Memory requested by the waiting processes
+    uint64_t pendingBytes() const;
+
+    // Smallest memory size among waiting processes, 0 if none are waiting
+    int smallestPendingSize() const;
+    AdmissionStats getStats() const;
+
+    // Checkpoint support: the waiting processes with the tick each started
+    // waiting, oldest first, and re-queueing one without trying to allocate
+    void getPending(std::vector<std::pair<std::shared_ptr<Process>, uint64_t>>& out) const;
+    void restorePending(std::shared_ptr<Process> p, uint64_t enqueueTick);
+
+private:
+    struct Entry {
+        std::shared_ptr<Process> process;
+        uint64_t seq;
+        uint64_t enqueueTick;
+    };
+
+    bool submitLocked(const std::shared_ptr<Process>& p, uint64_t now);
+    int sizeOf(const Process& p) const;
+    bool tryAllocate(Process& p);
+    void recordWait(uint64_t ticks);
+
+    MemoryManager& memoryManager_;
+    uint64_t maxHeadWaitTicks_;
+
+    mutable std::mutex mutex_;
+    std::map<int, std::deque<Entry>> bySize_;  // FIFO per memory size, ascending size
+    size_t pending_ = 0;
+    uint64_t pendingBytes_ = 0;
+    uint64_t nextSeq_ = 0;
+
+    uint64_t admitted_ = 0;
+    uint64_t backfilled_ = 0;
+    LatencyHistogram waitTicks_;   // fixed size however long the run
+};
@@ -0,0 +1,70 @@
+// Bytecode.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MappedFile.h"
+
+// One instruction as processes run it. Operands are resolved when the
+// program is built, so the interpreter never parses text. What an operand
+// holds depends on the opcode and its position (see operandRole):
+//   Name     index of the variable written, in the program's name table
+//   Value    a 16-bit immediate, or with OperandVariable set, the index of
+//            the variable read
+//   Address  a 32-bit address; UINT32_MAX when the text was not a number
+// Fixed width, so a FOR/END pair jumps by instruction index and a mapped
+// file can be executed in place.
+struct PackedInstruction {
+    uint8_t  opcode;
+    uint8_t  argc;          // as written, up to MaxArgs; only the first three are stored
+    uint16_t reserved;
+    uint32_t args[3];
+};
+static_assert(sizeof(PackedInstruction) == 16, "PackedInstruction must stay 16 bytes");
+
+const uint32_t OperandVariable = 0x80000000u;
+const size_t PackedOperands = 3;
+
+enum class OperandRole : uint8_t { Name, Value, Address };
+
+// DECLARE, ADD, SUBTRACT and READ write their first operand; READ reads
+// from its second and WRITE writes to its first. Everything else is a value.
+inline OperandRole operandRole(uint8_t opcode, size_t position) {
+    if (position == 0 && (opcode == 1 || opcode == 2 || opcode == 3 || opcode == 8)) return OperandRole::Name;
+    if ((opcode == 8 && position == 1) || (opcode == 9 && position == 0)) return OperandRole::Address;
+    return OperandRole::Value;
+}
+
+// True if the operand refers to the name table
+inline bool operandIsName(uint8_t opcode, size_t position, uint32_t operand) {
+    OperandRole role = operandRole(opcode, position);
+    return role == OperandRole::Name || (role == OperandRole::Value && (operand & OperandVariable));
+}
+
+// Variable names interned while programs are built
+struct NameTable {
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> index;
+
+    uint32_t intern(const std::string& name) {
+        auto it = index.find(name);
+        if (it != index.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(names.size());
+        names.push_back(name);
+        index.emplace(name, id);
+        return id;
+    }
+};
+
+// Bytecode and the names it refers to. A generated or replayed program owns
+// its code; the programs of a corpus file share one image whose code stays
+// in the mapped file.
+struct ProgramImage {
+    std::vector<std::string> names;
+    std::vector<PackedInstruction> code;    // empty when the code is mapped
+    std::shared_ptr<MappedFile> file;       // keeps mapped code alive
+};
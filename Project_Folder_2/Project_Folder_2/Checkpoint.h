@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Checkpoint file, laid out as
+//   header
+//   code       PackedInstruction[instructions], every program back to back;
+//              a program several processes share is stored once
+//   body       encoded with PackedCodec to the end of the file:
+//     policy name, next pid, max memory, mem-per-frame,
+//     name count and the variable names all programs share,
+//     one record per process:
+//       pid, CheckpointLocation, first instruction and instruction count of
+//       its program, enqueue tick (MemoryWait only), process state
+//       (Process::writeState)
+//     allocated block count, (start, end, pid) per block,
+//     byte count and the contents of those blocks back to back
+// Restored processes run their code in place from the mapped file, as
+// corpus programs do, so the file stays mapped while any of them is alive.
+// Ticks are as they were when the checkpoint was taken; a restore moves them
+// forward if the clock is already past that point.
+struct CheckpointFileHeader {
+    char     magic[8];      // "CSCHKPT1"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t tick;          // globalCpuTicks when taken
+    uint64_t steadyNanos;   // steady clock when taken
+    uint64_t processes;
+    uint64_t instructions;
+    uint64_t codeOffset;
+    uint64_t bodyOffset;
+};
+static_assert(sizeof(CheckpointFileHeader) == 64, "CheckpointFileHeader must stay 64 bytes");
+
+// Where a process was when the checkpoint was taken. A process held for its
+// last core, or one a core was running, is recorded as ready.
+enum class CheckpointLocation : uint8_t {
+    Ready = 0,          // in the ready queue, in queue order
+    Sleeping = 1,
+    MemoryWait = 2,     // waiting for admission, oldest first
+    Finished = 3,
+};
+
+// What a checkpoint or restore covered
+struct CheckpointSummary {
+    uint64_t tick = 0;          // tick recorded in the file
+    std::string policy;
+    size_t ready = 0;
+    size_t sleeping = 0;
+    size_t memoryWait = 0;
+    size_t finished = 0;
+    size_t allocatedBlocks = 0;
+    uint64_t bytes = 0;         // file size
+};
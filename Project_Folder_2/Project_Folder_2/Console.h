@@ -1,5 +1,7 @@
 ﻿// Console.h
 #pragma once
+#include <algorithm>
+#include <chrono>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
@@ -36,6 +38,48 @@ struct Config {
     int          max_overall_mem = 16384;    
     int          mem_per_proc = 4096;         
     int          mem_per_frame = 16;
+    std::string  memory_snapshot = "binary";          // binary | text | both
+    std::string  memory_log = "memory_events.bin";
+    uint32_t     memory_checkpoint_interval = 64;     // quanta between full checkpoints
+    int          min_mem_per_proc = 0;                // 0 = mem-per-proc
+    int          max_mem_per_proc = 0;                // 0 = mem-per-proc
+    uint64_t     admission_max_head_wait = 100000;    // ticks before backfilling stops
+    int          compaction_step_bytes = 4096;        // 0 disables compaction
+    double       mem_op_ratio = 0.0;                  // share of READ/WRITE instructions
+    int          tlb_entries = 16;                    // per-core software TLB size
+    int          memory_shards = 0;                   // 0 = one per core, capped so a shard fits max-mem-per-proc
+    int          mlfq_levels = 3;
+    std::vector<uint64_t> mlfq_quantums;              // per level; default doubles quantum-cycles per level
+    uint64_t     mlfq_boost_ticks = 100000;           // 0 disables priority boosts
+    uint64_t     affinity_max_wait = 2000;            // ticks a process may wait for its last core
+    uint64_t     cache_warmup_ticks = 0;              // cost of a cold start on a core
+    uint64_t     cache_warm_window = 2;               // other dispatches a core runs before p goes cold
+    bool         adaptive_quantum = false;            // rr only: quantum follows load and dispatch cost
+    uint64_t     quantum_min = 1;
+    uint64_t     quantum_max = 1000;
+    uint64_t     response_target_ticks = 20000;       // wanted wait before a queued process runs
+    double       max_switch_overhead = 0.05;          // share of core time allowed for dispatching
+    uint64_t     quantum_adjust_ticks = 5000;
+    std::string  quantum_log = "quantum_changes.log";
+    uint64_t     batch_submit_max = 1;                // processes the generator may submit per pass
+    uint64_t     backlog_high = 0;                    // processes waiting (ready + memory); 0 = no limit
+    uint64_t     backlog_low = 0;                     // 0 = half of backlog-high
+    uint64_t     pending_mem_high = 0;                // bytes asked for by processes waiting for memory; 0 = no limit
+    uint64_t     pending_mem_low = 0;                 // 0 = half of pending-mem-high
+    std::string  overload_policy = "pause";           // pause | drop
+    uint64_t     deadline_min_ticks = 0;              // relative deadlines of generated processes
+    uint64_t     deadline_max_ticks = 0;              // 0 = generated processes have no deadline
+    double       deadline_share = 1.0;                // share of generated processes with a deadline
+    bool         edf_admission_test = false;          // drop deadlines that would overload the machine
+    double       edf_density_bound = 1.0;
+    std::string  topology;                            // "SxCxK" sockets x clusters x cores; empty = flat
+    uint64_t     migration_penalty_cluster = 50;      // ticks to move to another cluster
+    uint64_t     migration_penalty_socket = 200;      // ticks to move to another socket
+    std::vector<std::pair<std::string, uint32_t>> process_groups;  // "name:tickets,..."; generator cycles through them
+    std::string  stats_segment = "csopesy-stats";     // shared-memory name for csopesy-top; "off" disables
+    std::string  metrics_target = "off";              // Prometheus text: a file path or "unix:<socket path>"
+    uint64_t     metrics_interval_ms = 1000;
+    std::string  program_corpus = "off";              // corpus file generated processes take programs from
 };
 
 
@@ -122,11 +166,25 @@ private:
             cout << "\nAvailable commands:" << endl;
             cout << "- initialize: Initialize the specifications of the OS (must be called first)" << endl;
             cout << "- screen -ls: Show active and finished processes" << endl;
-            cout << "- screen -s <process_name>: Create and attach to a new process screen" << endl;
+            cout << "- screen -s <process_name> [-g <group>] [-d <ticks>]: Create and attach to a new process screen" << endl;
             cout << "- screen -r <process_name>: Attach to an existing process screen" << endl;
             cout << "- scheduler-start: Start generating dummy processes and scheduling" << endl;
             cout << "- scheduler-stop: Stop generating dummy processes" << endl;
+            cout << "- scheduler-set <policy>: Switch to fcfs, rr, mlfq, sjf, srtf, stride or edf while running" << endl;
             cout << "- report-util: Generate CPU utilization report to file" << endl;
+            cout << "- trace-start [file]: Record scheduling events to a binary trace (default csopesy-trace.bin)" << endl;
+            cout << "- trace-stop: Stop recording; convert with tools/tracechrome" << endl;
+            cout << "- lock-stats [reset]: Show lock contention (builds with CSOPESY_LOCK_PROFILING)" << endl;
+            cout << "- profile [process_name]: Show the instruction mix of all cores or of one process" << endl;
+            cout << "- record-start [file]: Record every submitted process (default csopesy-workload.bin)" << endl;
+            cout << "- record-stop: Stop recording the workload" << endl;
+            cout << "- replay <file> [fast]: Submit a recorded workload at its arrival ticks; fast skips idle time" << endl;
+            cout << "- replay / replay-stop: Show replay progress / stop replaying" << endl;
+            cout << "- checkpoint <file>: Save every process, the memory and the clock to a file" << endl;
+            cout << "- restore <file>: Load a checkpoint into a freshly initialized emulator" << endl;
+            cout << "- corpus-build <file> <count>: Write count generated programs to a program corpus" << endl;
+            cout << "- corpus-load <file> / corpus-off: Make scheduler-start run a corpus's programs / random ones" << endl;
+            cout << "- corpus: Show the loaded corpus and how many of its programs were used" << endl;
             cout << "- clear: Clear the screen" << endl;
             cout << "- exit: Exit the program" << endl;
         }
@@ -146,18 +204,72 @@ private:
                     << "  delay_per_exec     = " << cfg_.delay_per_exec << '\n'
                     << "  max-overall-mem    = " << cfg_.max_overall_mem << '\n'
                     << "  mem-per-proc       = " << cfg_.mem_per_proc << '\n'
-                    << "  mem-per-frame      = " << cfg_.mem_per_frame << '\n';
+                    << "  mem-per-frame      = " << cfg_.mem_per_frame << '\n'
+                    << "  memory-snapshot    = " << cfg_.memory_snapshot << '\n';
 
                 
                 
+                // Every shard must be able to hold the largest process
+                int shards = cfg_.memory_shards > 0 ? cfg_.memory_shards : cfg_.num_cpu;
+                if (shards > cfg_.max_overall_mem / cfg_.max_mem_per_proc)
+                    shards = cfg_.max_overall_mem / cfg_.max_mem_per_proc;
+                if (shards < 1) shards = 1;
+                cout << "  memory shards      = " << shards << '\n';
+
                 memoryManager_ = std::make_unique<MemoryManager>(
-                    cfg_.max_overall_mem, cfg_.mem_per_proc, cfg_.mem_per_frame);
+                    cfg_.max_overall_mem, cfg_.mem_per_proc, cfg_.mem_per_frame, shards);
+                memoryManager_->setTextSnapshots(cfg_.memory_snapshot != "binary");
+                memoryManager_->configureTlbs(cfg_.num_cpu, static_cast<size_t>(cfg_.tlb_entries));
+                if (cfg_.memory_snapshot != "text" &&
+                    !memoryManager_->enableEventLog(cfg_.memory_log, cfg_.memory_checkpoint_interval)) {
+                    cout << "Warning: cannot open " << cfg_.memory_log << ", memory event log disabled\n";
+                }
 
                 scheduler_ = std::make_unique<Scheduler>(
                     cfg_.num_cpu, cfg_.scheduler, cfg_.quantum_cycles,
                     cfg_.batch_process_freq, cfg_.min_ins, cfg_.max_ins,
                     cfg_.delay_per_exec, *memoryManager_);  // pass reference
-
+                scheduler_->setMemoryRange(cfg_.min_mem_per_proc, cfg_.max_mem_per_proc);
+                scheduler_->setAdmissionMaxHeadWait(cfg_.admission_max_head_wait);
+                scheduler_->setCompactionStepBytes(cfg_.compaction_step_bytes);
+                scheduler_->setMemoryOpRatio(cfg_.mem_op_ratio);
+                // Kept even for other policies so scheduler-set can switch to mlfq
+                scheduler_->configureMlfq(cfg_.mlfq_quantums, cfg_.mlfq_boost_ticks);
+                if (!cfg_.topology.empty()) {
+                    TopologyShape shape;
+                    parseTopology(cfg_.topology, shape);
+                    scheduler_->configureTopology(shape, cfg_.migration_penalty_cluster,
+                        cfg_.migration_penalty_socket);
+                }
+                scheduler_->configureGroups(cfg_.process_groups);
+                scheduler_->configureDeadlines(cfg_.deadline_min_ticks, cfg_.deadline_max_ticks,
+                    cfg_.deadline_share, cfg_.edf_admission_test, cfg_.edf_density_bound);
+                scheduler_->configureBackpressure(static_cast<size_t>(cfg_.backlog_high),
+                    static_cast<size_t>(cfg_.backlog_low), cfg_.pending_mem_high, cfg_.pending_mem_low,
+                    cfg_.overload_policy == "drop");
+                scheduler_->setBatchSubmitMax(static_cast<size_t>(cfg_.batch_submit_max));
+                scheduler_->configureAffinity(cfg_.affinity_max_wait, cfg_.cache_warmup_ticks,
+                    cfg_.cache_warm_window);
+                if (cfg_.adaptive_quantum) {
+                    scheduler_->configureAdaptiveQuantum(cfg_.quantum_min, cfg_.quantum_max,
+                        cfg_.response_target_ticks, cfg_.max_switch_overhead,
+                        cfg_.quantum_adjust_ticks, cfg_.quantum_log);
+                }
+                if (cfg_.stats_segment != "off" && !scheduler_->configureStatsSegment(cfg_.stats_segment)) {
+                    cout << "Warning: cannot create shared memory '" << cfg_.stats_segment
+                        << "', live stats for csopesy-top disabled\n";
+                }
+                if (cfg_.metrics_target != "off"
+                    && !scheduler_->configureMetrics(cfg_.metrics_target, cfg_.metrics_interval_ms)) {
+                    cout << "Warning: cannot open metrics target '" << cfg_.metrics_target
+                        << "', metrics exposition disabled\n";
+                }
+                if (cfg_.program_corpus != "off") {
+                    string error;
+                    if (!scheduler_->loadCorpus(cfg_.program_corpus, error)) {
+                        cout << "Warning: " << error << "; generating random programs instead\n";
+                    }
+                }
 
                 scheduler_->start();          // Start the scheduler's main loop
                 startCpuTickThread();         // Start the global CPU tick counter
@@ -173,8 +285,34 @@ private:
         else { // Commands requiring initialization
             if (trimmedLine.rfind("screen -s ", 0) == 0) { // Starts with "screen -s "
                 string processName = trimmedLine.substr(trimmedLine.find("screen -s ") + 10);
-                if (processName.empty()) {
-                    cout << "Usage: screen -s <process_name>" << endl;
+                // Options after the name: -g <group> (fair-share group), -d <ticks> (deadline)
+                string group;
+                uint64_t deadlineTicks = 0;
+                bool badOption = false;
+                size_t optionStart = processName.find(" -");
+                if (optionStart != string::npos) {
+                    stringstream options(processName.substr(optionStart));
+                    processName = processName.substr(0, optionStart);
+                    string flag, value;
+                    while (options >> flag) {
+                        if (!(options >> value)) { badOption = true; break; }
+                        if (flag == "-g") group = value;
+                        else if (flag == "-d") {
+                            try { deadlineTicks = stoull(value); }
+                            catch (const exception&) { badOption = true; }
+                        }
+                        else badOption = true;
+                    }
+                }
+                bool knownGroup = group.empty();
+                for (const auto& g : cfg_.process_groups) {
+                    if (g.first == group) knownGroup = true;
+                }
+                if (processName.empty() || badOption) {
+                    cout << "Usage: screen -s <process_name> [-g <group>] [-d <deadline_ticks>]" << endl;
+                }
+                else if (!knownGroup) {
+                    cout << "Error: Unknown process group '" << group << "'. Groups come from process-groups in config.txt." << endl;
                 }
                 else {
                     // Check if process name already exists
@@ -211,7 +349,10 @@ private:
                         // Create a new process and submit to scheduler
                         // PID will be assigned by scheduler's internal counter or a new mechanism
                         auto newProcess = make_shared<Process>(scheduler_->getNextProcessId(), processName);
-                        newProcess->genRandInst(cfg_.min_ins, cfg_.max_ins); // Generate instructions
+                        newProcess->setGroup(group);
+                        newProcess->setRelativeDeadline(deadlineTicks);
+                        newProcess->setMemorySize(scheduler_->drawMemorySize());
+                        newProcess->genRandInst(cfg_.min_ins, cfg_.max_ins, cfg_.mem_op_ratio); // Generate instructions
                         scheduler_->submit(newProcess);
                         cout << "Process '" << processName << "' (PID: " << newProcess->getPid() << ") created and submitted." << endl;
                         // Attach to screen
@@ -235,32 +376,7 @@ private:
                     cout << "Usage: screen -r <process_name>" << endl;
                 }
                 else {
-                    shared_ptr<Process> targetProcess = nullptr;
-                    // Check running processes
-                    for (const auto& p : scheduler_->getRunningProcesses()) {
-                        if (p->getName() == processName) {
-                            targetProcess = p;
-                            break;
-                        }
-                    }
-                    // Check finished processes if not found in running
-                    if (!targetProcess) {
-                        for (const auto& p : scheduler_->getFinishedProcesses()) {
-                            if (p->getName() == processName) {
-                                targetProcess = p;
-                                break;
-                            }
-                        }
-                    }
-                    // Check sleeping processes if not found in running or finished
-                    if (!targetProcess) {
-                        for (const auto& p : scheduler_->getSleepingProcesses()) { // Assuming a getter for sleeping processes
-                            if (p->getName() == processName) {
-                                targetProcess = p;
-                                break;
-                            }
-                        }
-                    }
+                    shared_ptr<Process> targetProcess = findProcess(processName);
 
                     if (targetProcess) {
                         if (targetProcess->isFinished()) {
@@ -286,9 +402,12 @@ private:
 
             else if (trimmedLine == "screen -ls") {
                 system("cls");
-                cout << "CPU utilization:  " << fixed << setprecision(2) << scheduler_->getCpuUtilization() << "%\n";
+                printUtilization(cout);
                 cout << "Cores used:       " << scheduler_->getCoresUsed() << '\n';
-                cout << "Cores available:  " << scheduler_->getCoresAvailable() << "\n\n";
+                cout << "Cores available:  " << scheduler_->getCoresAvailable() << "\n";
+                printAffinity(cout);
+                printBackpressure(cout);
+                cout << "\n";
 
                 cout << "----------------------------\n";
                 cout << "Running processes:\n";
@@ -357,22 +476,351 @@ private:
 
             
             else if (trimmedLine == "scheduler-start") {
-                scheduler_->startProcessGeneration();
-                cout << "Scheduler process generation started." << endl;
+                if (scheduler_->isReplaying()) {
+                    cout << "A workload is being replayed; use replay-stop first." << endl;
+                }
+                else {
+                    scheduler_->startProcessGeneration();
+                    cout << "Scheduler process generation started." << endl;
+                }
             }
             else if (trimmedLine == "scheduler-stop") {
                 scheduler_->stopProcessGeneration();
                 cout << "Scheduler process generation stopped." << endl;
             }
+            else if (trimmedLine.rfind("scheduler-set ", 0) == 0) {
+                string policy = trimmedLine.substr(14);
+                size_t migrated = 0;
+                if (!isSchedulingPolicyName(policy)) {
+                    cout << "Unknown policy '" << policy << "'. Use fcfs, rr, mlfq, sjf, srtf, stride or edf.\n";
+                }
+                else if (usesQuantumCycles(policy) && cfg_.quantum_cycles < 1) {
+                    cout << "quantum-cycles must be at least 1 for the " << policy << " scheduler\n";
+                }
+                else if (scheduler_->setPolicy(policy, migrated)) {
+                    cout << "Scheduler switched from " << cfg_.scheduler << " to " << policy << ", "
+                        << migrated << " queued processes migrated.\n";
+                    cfg_.scheduler = policy;
+                }
+            }
             else if (trimmedLine == "report-util") {
                 generateReport();
             }
+            else if (trimmedLine == "trace-start" || trimmedLine.rfind("trace-start ", 0) == 0) {
+                string path = trimmedLine.size() > 12 ? trimmedLine.substr(12) : "csopesy-trace.bin";
+                if (scheduler_->tracer().enabled()) {
+                    cout << "Tracing is already on; use trace-stop first.\n";
+                }
+                else if (scheduler_->tracer().start(path)) {
+                    cout << "Tracing scheduling events to " << path << "\n";
+                }
+                else {
+                    cout << "Error: Cannot create " << path << "\n";
+                }
+            }
+            else if (trimmedLine == "trace-stop") {
+                if (!scheduler_->tracer().enabled()) {
+                    cout << "Tracing is not on.\n";
+                }
+                else {
+                    uint64_t dropped = 0;
+                    uint64_t written = scheduler_->tracer().stop(dropped);
+                    cout << "Tracing stopped: " << written << " events written, " << dropped
+                        << " dropped because a ring was full.\n";
+                }
+            }
+            else if (trimmedLine == "record-start" || trimmedLine.rfind("record-start ", 0) == 0) {
+                string path = trimmedLine.size() > 13 ? trimmedLine.substr(13) : "csopesy-workload.bin";
+                if (scheduler_->isRecording()) {
+                    cout << "Already recording; use record-stop first.\n";
+                }
+                else if (scheduler_->startRecording(path)) {
+                    cout << "Recording submitted processes to " << path << "\n";
+                }
+                else {
+                    cout << "Cannot open " << path << " for writing.\n";
+                }
+            }
+            else if (trimmedLine == "record-stop") {
+                if (!scheduler_->isRecording()) {
+                    cout << "Not recording.\n";
+                }
+                else {
+                    cout << "Recording stopped: " << scheduler_->stopRecording() << " processes written.\n";
+                }
+            }
+            else if (trimmedLine.rfind("replay ", 0) == 0) {
+                istringstream args(trimmedLine.substr(7));
+                string path, mode;
+                args >> path >> mode;
+                string error;
+                if (mode != "" && mode != "fast") {
+                    cout << "Usage: replay <file> [fast]\n";
+                }
+                else if (scheduler_->isGenerating()) {
+                    cout << "The generator is running; use scheduler-stop first.\n";
+                }
+                else if (!scheduler_->startReplay(path, mode == "fast", error)) {
+                    cout << "Cannot replay: " << error << "\n";
+                }
+                else {
+                    cout << "Replaying " << scheduler_->getReplayProgress().total << " processes from " << path
+                        << (mode == "fast" ? ", skipping idle time" : "") << ".\n";
+                }
+            }
+            else if (trimmedLine == "replay") {
+                ReplayProgress rp = scheduler_->getReplayProgress();
+                cout << "Replay " << (rp.active ? "running" : "not running") << (rp.fast ? " (fast)" : "") << ": "
+                    << rp.submitted << " of " << rp.total << " processes submitted\n";
+                if (rp.resized > 0) {
+                    cout << rp.resized << " recorded memory sizes did not suit the current config and were redrawn\n";
+                }
+                if (!rp.error.empty()) cout << "Stopped early: " << rp.error << "\n";
+            }
+            else if (trimmedLine == "replay-stop") {
+                scheduler_->stopReplay();
+                cout << "Replay stopped after " << scheduler_->getReplayProgress().submitted << " processes.\n";
+            }
+            else if (trimmedLine.rfind("checkpoint ", 0) == 0 || trimmedLine.rfind("restore ", 0) == 0) {
+                bool restoring = trimmedLine[0] == 'r';
+                string path = trimmedLine.substr(restoring ? 8 : 11);
+                CheckpointSummary summary;
+                string error;
+                auto started = std::chrono::steady_clock::now();
+                bool ok = restoring ? scheduler_->restoreCheckpoint(path, summary, error)
+                    : scheduler_->writeCheckpoint(path, summary, error);
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+                if (!ok) {
+                    cout << (restoring ? "Cannot restore: " : "Cannot checkpoint: ") << error << "\n";
+                }
+                else {
+                    if (restoring) cfg_.scheduler = summary.policy;
+                    cout << (restoring ? "Restored " : "Checkpointed ")
+                        << summary.ready + summary.sleeping + summary.memoryWait + summary.finished << " processes ("
+                        << summary.ready << " ready, " << summary.sleeping << " sleeping, " << summary.memoryWait
+                        << " waiting for memory, " << summary.finished << " finished) at tick " << summary.tick
+                        << " under " << summary.policy << "; " << summary.allocatedBlocks << " memory blocks, "
+                        << summary.bytes << " bytes, " << fixed << setprecision(1) << ms << " ms\n";
+                }
+            }
+            else if (trimmedLine.rfind("corpus-build ", 0) == 0) {
+                istringstream args(trimmedLine.substr(13));
+                string path;
+                uint64_t count = 0;
+                string error;
+                auto started = std::chrono::steady_clock::now();
+                if (!(args >> path >> count) || count < 1) {
+                    cout << "Usage: corpus-build <file> <count>\n";
+                }
+                else if (!scheduler_->buildCorpus(path, count, error)) {
+                    cout << "Cannot build corpus: " << error << "\n";
+                }
+                else {
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+                    cout << "Wrote " << count << " programs to " << path << " in " << fixed << setprecision(1)
+                        << ms << " ms\n";
+                }
+            }
+            else if (trimmedLine.rfind("corpus-load ", 0) == 0) {
+                string path = trimmedLine.substr(12);
+                string error;
+                auto started = std::chrono::steady_clock::now();
+                if (!scheduler_->loadCorpus(path, error)) {
+                    cout << "Cannot load corpus: " << error << "\n";
+                }
+                else {
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+                    CorpusStatus cs = scheduler_->getCorpusStatus();
+                    cout << "Loaded " << cs.programs << " programs (" << cs.instructions << " instructions) from "
+                        << path << " in " << fixed << setprecision(1) << ms << " ms\n";
+                }
+            }
+            else if (trimmedLine == "corpus-off") {
+                string error;
+                if (!scheduler_->clearCorpus(error)) cout << "Cannot unload corpus: " << error << "\n";
+                else cout << "Generated processes get random programs again.\n";
+            }
+            else if (trimmedLine == "corpus") {
+                CorpusStatus cs = scheduler_->getCorpusStatus();
+                if (!cs.loaded) {
+                    cout << "No corpus loaded; generated processes get random programs.\n";
+                }
+                else {
+                    cout << "Corpus " << cs.path << ": " << cs.programs << " programs, " << cs.instructions
+                        << " instructions; " << cs.drawn << " drawn";
+                    if (cs.damaged) cout << ", " << cs.damaged << " damaged entries skipped";
+                    cout << "\n";
+                }
+            }
+            else if (trimmedLine == "profile") {
+                printOpcodeProfile(cout);
+            }
+            else if (trimmedLine.rfind("profile ", 0) == 0) {
+                string processName = trimmedLine.substr(8);
+                shared_ptr<Process> p = findProcess(processName);
+                if (p) printProcessProfile(cout, *p);
+                else cout << "Process '" << processName << "' not found." << endl;
+            }
+            else if (trimmedLine == "lock-stats" || trimmedLine == "lock-stats reset") {
+                if (!lockProfilingEnabled()) {
+                    cout << "Lock profiling is not built in; rebuild with CSOPESY_LOCK_PROFILING defined.\n";
+                }
+                else if (trimmedLine == "lock-stats reset") {
+                    resetLockProfiles();
+                    cout << "Lock statistics cleared.\n";
+                }
+                else {
+                    printLockStats(cout);
+                }
+            }
             else {
                 cout << "[" << getCurrentTimestamp() << "] Unknown command: " << trimmedLine << '\n';
             }
         }
     }
 
+    // Busy share over 1s/10s/60s; a window with less history than its length
+    // shows how much it covers
+    void printUtilization(ostream& out) {
+        auto windows = scheduler_->getUtilization();
+        out << "CPU utilization:  " << fixed << setprecision(2) << scheduler_->getCpuUtilization() << "%\n";
+        out << "                  ";
+        for (const auto& w : windows) {
+            out << setw(8) << right << (to_string(w.seconds) + "s");
+        }
+        out << left << "\n";
+        out << "  total           ";
+        for (const auto& w : windows) out << setw(7) << right << w.total << "%";
+        out << left << "\n";
+        for (int i = 0; i < cfg_.num_cpu; ++i) {
+            out << "  core " << setw(11) << left << i;
+            for (const auto& w : windows) out << setw(7) << right << w.perCore[i] << "%";
+            out << left << "\n";
+        }
+        for (const auto& w : windows) {
+            if (w.coveredSeconds + 0.05 < w.seconds) {
+                out << "  (" << w.seconds << "s window covers " << setprecision(1) << w.coveredSeconds
+                    << "s so far)\n" << setprecision(2);
+            }
+        }
+    }
+
+    // p50/p90/p99/max per policy, in ticks and in milliseconds of wall time
+    void printLatency(ostream& out) {
+        static const char* const names[LatencyMetricCount] = { "response", "wait", "run", "turnaround" };
+        for (const auto& pl : scheduler_->getLatencyStats()) {
+            out << "Latency under " << pl.policy << " (" << pl.finished
+                << " processes; p50 / p90 / p99 / max):\n";
+            for (int m = 0; m < LatencyMetricCount; ++m) {
+                const LatencySummary& t = pl.ticks[m];
+                const LatencySummary& n = pl.nanos[m];
+                out << "  " << setw(11) << left << names[m]
+                    << t.p50 << " / " << t.p90 << " / " << t.p99 << " / " << t.max << " ticks   "
+                    << setprecision(3) << n.p50 / 1e6 << " / " << n.p90 / 1e6 << " / " << n.p99 / 1e6
+                    << " / " << n.max / 1e6 << " ms\n" << setprecision(2);
+            }
+        }
+    }
+
+    // Running, then finished, then sleeping processes; nullptr if none matches
+    shared_ptr<Process> findProcess(const string& name) {
+        for (const auto& p : scheduler_->getRunningProcesses()) {
+            if (p->getName() == name) return p;
+        }
+        for (const auto& p : scheduler_->getFinishedProcesses()) {
+            if (p->getName() == name) return p;
+        }
+        for (const auto& p : scheduler_->getSleepingProcesses()) {
+            if (p->getName() == name) return p;
+        }
+        return nullptr;
+    }
+
+    // Timing is sampled (one instruction in Core::OpcodeSamplePeriod per core)
+    // and includes the interpreter's own bookkeeping
+    void printOpcodeProfile(ostream& out) {
+        OpcodeProfile prof = scheduler_->getOpcodeProfile();
+        uint64_t total = 0;
+        for (int op = 1; op < Process::OpcodeCount; ++op) total += prof.executed[op];
+        out << "Instruction mix, all cores: " << total << " executed, " << fixed << setprecision(1)
+            << (total ? 100.0 * prof.loopBodyInstructions / total : 0.0) << "% inside FOR bodies, "
+            << prof.loopIterations << " loop passes\n";
+        out << left << setw(10) << "OPCODE" << right << setw(12) << "EXECUTED" << setw(9) << "SHARE"
+            << setw(12) << "SAMPLES" << setw(12) << "MEAN ns" << "\n";
+        for (int op = 1; op < Process::OpcodeCount; ++op) {
+            out << left << setw(10) << Process::opcodeName(static_cast<uint8_t>(op)) << right
+                << setw(12) << prof.executed[op]
+                << setw(8) << (total ? 100.0 * prof.executed[op] / total : 0.0) << "%"
+                << setw(12) << prof.samples[op]
+                << setw(12) << (prof.samples[op] ? static_cast<double>(prof.sampleNanos[op]) / prof.samples[op] : 0.0)
+                << "\n";
+        }
+    }
+
+    void printProcessProfile(ostream& out, const Process& p) {
+        uint64_t total = 0;
+        for (int op = 1; op < Process::OpcodeCount; ++op) total += p.getOpcodeCount(op);
+        out << "Instruction mix of " << p.getName() << ": " << total << " executed, " << fixed << setprecision(1)
+            << (total ? 100.0 * p.getLoopBodyInstructions() / total : 0.0) << "% inside FOR bodies\n";
+        out << left << setw(10) << "OPCODE" << right << setw(12) << "EXECUTED" << setw(9) << "SHARE" << "\n";
+        for (int op = 1; op < Process::OpcodeCount; ++op) {
+            if (p.getOpcodeCount(op) == 0) continue;
+            out << left << setw(10) << Process::opcodeName(static_cast<uint8_t>(op)) << right
+                << setw(12) << p.getOpcodeCount(op)
+                << setw(8) << 100.0 * p.getOpcodeCount(op) / total << "%\n";
+        }
+
+        vector<pair<size_t, uint64_t>> loops;
+        for (const auto& loop : p.getLoopIterations()) {
+            if (loop.second > 0) loops.push_back(loop);
+        }
+        sort(loops.begin(), loops.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        if (loops.empty()) {
+            out << "No loop has finished a pass yet.\n";
+            return;
+        }
+        out << "Hottest loops (FOR instruction, passes):\n";
+        for (size_t i = 0; i < loops.size() && i < 10; ++i) {
+            out << "  #" << loops[i].first << "  " << loops[i].second << "\n";
+        }
+    }
+
+    // Wait is over contended acquisitions only; times in microseconds
+    void printLockStats(ostream& out) {
+        out << left << setw(38) << "LOCK" << right << setw(12) << "ACQUIRED" << setw(10) << "CONTENDED"
+            << setw(24) << "WAIT p50/p99/max us" << setw(24) << "HOLD p50/p99/max us" << setw(12) << "HELD ms" << "\n";
+        out << fixed << setprecision(1);
+        for (const auto& lp : getLockProfiles()) {
+            ostringstream wait, hold;
+            wait << fixed << setprecision(1) << lp.waitP50 / 1e3 << "/" << lp.waitP99 / 1e3 << "/" << lp.waitMax / 1e3;
+            hold << fixed << setprecision(1) << lp.holdP50 / 1e3 << "/" << lp.holdP99 / 1e3 << "/" << lp.holdMax / 1e3;
+            out << left << setw(38) << lp.name << right << setw(12) << lp.acquisitions
+                << setw(9) << (lp.acquisitions ? 100.0 * lp.contended / lp.acquisitions : 0.0) << "%"
+                << setw(24) << wait.str() << setw(24) << hold.str() << setw(12) << lp.holdTotal / 1e6 << "\n";
+        }
+    }
+
+    // Rates are over dispatches of processes that had run before
+    void printAffinity(ostream& out) {
+        AffinityStats st = scheduler_->getAffinityStats();
+        uint64_t placed = st.affinityHits + st.migrations;
+        uint64_t starts = st.coldStarts + st.warmStarts;
+        out << "Affinity hits:    " << fixed << setprecision(2)
+            << (placed ? 100.0 * st.affinityHits / placed : 0.0) << "% (" << st.affinityHits << ")\n";
+        out << "Migrations:       " << (placed ? 100.0 * st.migrations / placed : 0.0)
+            << "% (" << st.migrations << ")\n";
+        out << "Cold starts:      " << (starts ? 100.0 * st.coldStarts / starts : 0.0) << "% ("
+            << st.warmupTicks << " warm-up ticks), " << st.held << " waiting for their core\n";
+    }
+
+    void printBackpressure(ostream& out) {
+        BackpressureStats bp = scheduler_->getBackpressureStats();
+        out << "Backlog:          " << bp.readyDepth << " ready, " << bp.memoryDepth << " waiting for memory ("
+            << bp.pendingBytes << " bytes)" << (bp.throttled ? ", generator throttled" : "") << "\n";
+        out << "Throttled:        " << bp.throttleEpisodes << " times, " << bp.pausedArrivals << " arrivals paused ("
+            << bp.deferredArrivals << " still owed), " << bp.droppedArrivals << " dropped\n";
+    }
+
     void generateReport() {
         ofstream out("csopesy-log.txt");
         if (!out) {
@@ -381,9 +829,11 @@ private:
         }
 
         out << "CSOPESY Emulator Report - " << getCurrentTimestamp() << "\n\n";
-        out << "CPU utilization: " << fixed << setprecision(2) << scheduler_->getCpuUtilization() << "%" << endl;
+        printUtilization(out);
         out << "Cores used: " << scheduler_->getCoresUsed() << endl;
         out << "Cores available: " << scheduler_->getCoresAvailable() << endl;
+        printAffinity(out);
+        printBackpressure(out);
 
         out << "\n----------------------------\n";
         out << "Running processes:\n";
@@ -442,6 +892,84 @@ private:
             }
         }
 
+        out << "\nMean turnaround (" << cfg_.scheduler << "): "
+            << scheduler_->getMeanTurnaroundTicks() << " ticks\n";
+        printLatency(out);
+        uint64_t dispatched = scheduler_->getDispatchCount();
+        out << "Ready queue: " << scheduler_->getReadyQueueLockAcquisitions() << " lock acquisitions for "
+            << dispatched << " dispatches ("
+            << (dispatched ? static_cast<double>(scheduler_->getReadyQueueLockAcquisitions()) / dispatched : 0.0)
+            << " per dispatch)\n";
+        if (scheduler_->hasAdaptiveQuantum()) {
+            QuantumStats qs = scheduler_->getQuantumStats();
+            out << "Adaptive quantum: " << qs.quantum << " ticks after " << qs.changes << " changes (see "
+                << cfg_.quantum_log << "), dispatch cost " << qs.switchNanos << " ns, "
+                << qs.nanosPerTick << " ns per tick, ready queue " << qs.readyDepth << "\n";
+        }
+
+        if (scheduler_->hasTopology()) {
+            const TopologyShape& shape = scheduler_->getTopology();
+            TopologyStats ts = scheduler_->getTopologyStats();
+            AffinityStats as = scheduler_->getAffinityStats();
+            out << "\nTopology: " << shape.sockets << " sockets x " << shape.clustersPerSocket
+                << " clusters x " << shape.coresPerCluster << " cores\n";
+            out << "Run-queue pops: " << ts.localPops << " local, " << ts.clusterSteals
+                << " stolen within a socket, " << ts.socketSteals << " stolen across sockets\n";
+            out << "Migrations: " << as.crossCluster << " across clusters, " << as.crossSocket
+                << " across sockets, " << as.penaltyTicks << " penalty ticks\n";
+        }
+
+        DeadlineStats ds = scheduler_->getDeadlineStats();
+        if (ds.met + ds.missed + ds.demoted + ds.active > 0) {
+            out << "\nDeadlines: " << ds.met << " met, " << ds.missed << " missed (worst lateness "
+                << ds.maxLateness << " ticks), " << ds.active << " still running, "
+                << ds.demoted << " dropped by the admission test\n";
+        }
+
+        auto groups = scheduler_->getGroupStats();
+        if (!groups.empty()) {
+            out << "\nFair share by group (core ticks):\n";
+            for (const auto& g : groups) {
+                out << setw(12) << left << g.name << " tickets " << g.tickets
+                    << "  target " << 100.0 * g.targetShare << "%  achieved " << 100.0 * g.achievedShare
+                    << "% (" << g.ticks << " ticks), queued " << g.queued << "\n";
+            }
+        }
+
+        auto levels = scheduler_->getMlfqStats();
+        if (!levels.empty()) {
+            out << "\nMLFQ response time per level (ticks from entering the queue to dispatch):\n";
+            for (size_t i = 0; i < levels.size(); ++i) {
+                const auto& lv = levels[i];
+                out << "Level " << i << " (quantum " << lv.quantum << "): "
+                    << lv.dispatches << " dispatches, avg "
+                    << (lv.dispatches ? static_cast<double>(lv.totalWait) / lv.dispatches : 0.0)
+                    << ", max " << lv.maxWait << ", queued " << lv.queued << "\n";
+            }
+        }
+
+        AdmissionStats adm = scheduler_->getAdmissionStats();
+        out << "\nMemory admission:\n";
+        out << "Admitted: " << adm.admitted << "  Backfilled: " << adm.backfilled
+            << "  Waiting for memory: " << adm.pending << "\n";
+        out << "Admission wait (ticks): p50 " << adm.p50 << "  p90 " << adm.p90
+            << "  p99 " << adm.p99 << "  max " << adm.max << "\n";
+
+        CompactionStats cs = memoryManager_->getCompactionStats();
+        out << "Compaction: " << cs.relocations << " relocations in " << cs.steps << " steps, "
+            << cs.bytesMoved << " bytes moved, " << cs.fragmentationRecovered
+            << " bytes of fragmentation recovered\n";
+        out << "External fragmentation now: " << memoryManager_->externalFragmentation() << " bytes\n";
+        out << "Memory shards: " << memoryManager_->getShardCount() << ", allocations borrowed from a neighbour: "
+            << memoryManager_->getBorrowCount() << "\n";
+
+        uint64_t tlbHits = memoryManager_->getTlbHits();
+        uint64_t tlbMisses = memoryManager_->getTlbMisses();
+        uint64_t tlbTotal = tlbHits + tlbMisses;
+        out << "TLB: " << tlbHits << " hits, " << tlbMisses << " misses ("
+            << (tlbTotal ? 100.0 * tlbHits / tlbTotal : 0.0) << "% hit rate), "
+            << memoryManager_->getPageWalks() << " page table walks\n";
+
         out << "----------------------------\n";
         cout << "Report written to csopesy-log.txt\n";
     }
@@ -471,6 +999,75 @@ private:
             cfg_.max_overall_mem = stoi(kv.at("max-overall-mem"));          
             cfg_.mem_per_proc = stoi(kv.at("mem-per-proc"));                
             cfg_.mem_per_frame = stoi(kv.at("mem-per-frame"));
+
+            // Optional settings
+            if (kv.count("memory-snapshot")) cfg_.memory_snapshot = kv.at("memory-snapshot");
+            if (kv.count("memory-log")) cfg_.memory_log = kv.at("memory-log");
+            if (kv.count("memory-checkpoint-interval"))
+                cfg_.memory_checkpoint_interval = static_cast<uint32_t>(stoul(kv.at("memory-checkpoint-interval")));
+            cfg_.min_mem_per_proc = kv.count("min-mem-per-proc") ? stoi(kv.at("min-mem-per-proc")) : cfg_.mem_per_proc;
+            cfg_.max_mem_per_proc = kv.count("max-mem-per-proc") ? stoi(kv.at("max-mem-per-proc")) : cfg_.mem_per_proc;
+            if (kv.count("admission-max-head-wait"))
+                cfg_.admission_max_head_wait = stoull(kv.at("admission-max-head-wait"));
+            if (kv.count("compaction-step-bytes"))
+                cfg_.compaction_step_bytes = stoi(kv.at("compaction-step-bytes"));
+            if (kv.count("mem-op-ratio")) cfg_.mem_op_ratio = stod(kv.at("mem-op-ratio"));
+            if (kv.count("tlb-entries")) cfg_.tlb_entries = stoi(kv.at("tlb-entries"));
+            if (kv.count("memory-shards")) cfg_.memory_shards = stoi(kv.at("memory-shards"));
+            if (kv.count("mlfq-levels")) cfg_.mlfq_levels = stoi(kv.at("mlfq-levels"));
+            if (kv.count("mlfq-boost-ticks")) cfg_.mlfq_boost_ticks = stoull(kv.at("mlfq-boost-ticks"));
+            if (kv.count("affinity-max-wait")) cfg_.affinity_max_wait = stoull(kv.at("affinity-max-wait"));
+            if (kv.count("cache-warmup-ticks")) cfg_.cache_warmup_ticks = stoull(kv.at("cache-warmup-ticks"));
+            if (kv.count("cache-warm-window")) cfg_.cache_warm_window = stoull(kv.at("cache-warm-window"));
+            if (kv.count("adaptive-quantum")) cfg_.adaptive_quantum = kv.at("adaptive-quantum") == "true";
+            if (kv.count("quantum-min")) cfg_.quantum_min = stoull(kv.at("quantum-min"));
+            if (kv.count("quantum-max")) cfg_.quantum_max = stoull(kv.at("quantum-max"));
+            if (kv.count("response-target-ticks"))
+                cfg_.response_target_ticks = stoull(kv.at("response-target-ticks"));
+            if (kv.count("max-switch-overhead")) cfg_.max_switch_overhead = stod(kv.at("max-switch-overhead"));
+            if (kv.count("quantum-adjust-ticks")) cfg_.quantum_adjust_ticks = stoull(kv.at("quantum-adjust-ticks"));
+            if (kv.count("quantum-log")) cfg_.quantum_log = kv.at("quantum-log");
+            if (kv.count("backlog-high")) cfg_.backlog_high = stoull(kv.at("backlog-high"));
+            cfg_.backlog_low = kv.count("backlog-low") ? stoull(kv.at("backlog-low")) : cfg_.backlog_high / 2;
+            if (kv.count("pending-mem-high")) cfg_.pending_mem_high = stoull(kv.at("pending-mem-high"));
+            cfg_.pending_mem_low = kv.count("pending-mem-low") ? stoull(kv.at("pending-mem-low"))
+                : cfg_.pending_mem_high / 2;
+            if (kv.count("overload-policy")) cfg_.overload_policy = kv.at("overload-policy");
+            if (kv.count("deadline-min-ticks")) cfg_.deadline_min_ticks = stoull(kv.at("deadline-min-ticks"));
+            if (kv.count("deadline-max-ticks")) cfg_.deadline_max_ticks = stoull(kv.at("deadline-max-ticks"));
+            if (kv.count("deadline-share")) cfg_.deadline_share = stod(kv.at("deadline-share"));
+            if (kv.count("edf-admission-test")) cfg_.edf_admission_test = kv.at("edf-admission-test") == "true";
+            if (kv.count("edf-density-bound")) cfg_.edf_density_bound = stod(kv.at("edf-density-bound"));
+            if (kv.count("topology")) cfg_.topology = kv.at("topology");
+            if (kv.count("migration-penalty-cluster"))
+                cfg_.migration_penalty_cluster = stoull(kv.at("migration-penalty-cluster"));
+            if (kv.count("migration-penalty-socket"))
+                cfg_.migration_penalty_socket = stoull(kv.at("migration-penalty-socket"));
+            if (kv.count("batch-submit-max")) cfg_.batch_submit_max = stoull(kv.at("batch-submit-max"));
+            if (kv.count("stats-segment")) cfg_.stats_segment = kv.at("stats-segment");
+            if (kv.count("metrics-target")) cfg_.metrics_target = kv.at("metrics-target");
+            if (kv.count("metrics-interval-ms")) cfg_.metrics_interval_ms = stoull(kv.at("metrics-interval-ms"));
+            if (kv.count("program-corpus")) cfg_.program_corpus = kv.at("program-corpus");
+            cfg_.process_groups.clear();
+            if (kv.count("process-groups")) {
+                // "web:3,batch:1"; tickets default to 1
+                stringstream ss(kv.at("process-groups"));
+                string item;
+                while (getline(ss, item, ',')) {
+                    size_t colon = item.find(':');
+                    string name = item.substr(0, colon);
+                    uint32_t tickets = colon == string::npos ? 1 : static_cast<uint32_t>(stoul(item.substr(colon + 1)));
+                    if (!name.empty()) cfg_.process_groups.emplace_back(name, tickets);
+                }
+            }
+            cfg_.mlfq_quantums.clear();
+            if (kv.count("mlfq-quantums")) {
+                // Comma separated, one per level: "2,4,8"
+                stringstream ss(kv.at("mlfq-quantums"));
+                string item;
+                while (getline(ss, item, ',')) cfg_.mlfq_quantums.push_back(stoull(item));
+                cfg_.mlfq_levels = static_cast<int>(cfg_.mlfq_quantums.size());
+            }
         }
         catch (const out_of_range& oor) {
             (void)oor; // Suppress unused variable warning
@@ -487,17 +1084,42 @@ private:
         }
 
         /* Basic range checks */
-        if (cfg_.num_cpu < 1 || cfg_.num_cpu > 128) {
-            cout << "num-cpu out of range (1–128)\n"; return false;
+        if (!cfg_.topology.empty()) {
+            // A topology lifts the flat 128-core limit
+            TopologyShape shape;
+            if (!parseTopology(cfg_.topology, shape)) {
+                cout << "topology must look like <sockets>x<clusters>x<cores>, e.g. 2x4x8\n"; return false;
+            }
+            if (shape.cores() != cfg_.num_cpu) {
+                cout << "topology " << cfg_.topology << " has " << shape.cores()
+                    << " cores but num-cpu is " << cfg_.num_cpu << "\n"; return false;
+            }
+            if (cfg_.num_cpu > 4096) {
+                cout << "num-cpu out of range (1–4096 with a topology)\n"; return false;
+            }
+        }
+        else if (cfg_.num_cpu < 1 || cfg_.num_cpu > 128) {
+            cout << "num-cpu out of range (1–128, or up to 4096 with a topology)\n"; return false;
+        }
+        if (!isSchedulingPolicyName(cfg_.scheduler)) {
+            cout << "scheduler must be 'fcfs', 'rr', 'mlfq', 'sjf', 'srtf', 'stride' or 'edf'\n"; return false;
+        }
+        // MLFQ levels are checked for every policy since scheduler-set can switch to mlfq
+        if (cfg_.mlfq_levels < 1 || cfg_.mlfq_levels > 64) {
+            cout << "mlfq-levels must be between 1 and 64\n"; return false;
+        }
+        if (cfg_.mlfq_quantums.empty()) {
+            uint64_t q = cfg_.quantum_cycles < 1 ? 1 : cfg_.quantum_cycles;
+            for (int i = 0; i < cfg_.mlfq_levels; ++i, q *= 2) cfg_.mlfq_quantums.push_back(q);
         }
-        if (cfg_.scheduler != "fcfs" && cfg_.scheduler != "rr") {
-            cout << "scheduler must be 'fcfs' or 'rr'\n"; return false;
+        for (uint64_t q : cfg_.mlfq_quantums) {
+            if (q < 1) { cout << "mlfq-quantums must all be at least 1\n"; return false; }
         }
         // Additional range checks for uint64_t parameters as per spec.
         // For uint64_t, values are generally positive. Max limits are 2^32, but stoull already handles max uint64_t.
         // We only need to check against 1 for minimums if they are specified in the config.
-        if (cfg_.quantum_cycles < 1 && cfg_.scheduler == "rr") { // Quantum must be at least 1 for RR
-            cout << "quantum-cycles must be at least 1 for Round Robin scheduler\n"; return false;
+        if (cfg_.quantum_cycles < 1 && usesQuantumCycles(cfg_.scheduler)) { // Quantum must be at least 1 for preemptive policies
+            cout << "quantum-cycles must be at least 1 for the " << cfg_.scheduler << " scheduler\n"; return false;
         }
         if (cfg_.batch_process_freq < 1) {
             cout << "batch-process-freq must be at least 1\n"; return false;
@@ -505,6 +1127,69 @@ private:
         if (cfg_.min_ins < 1 || cfg_.max_ins < 1 || cfg_.min_ins > cfg_.max_ins) {
             cout << "min-ins and max-ins must be at least 1, and min-ins <= max-ins\n"; return false;
         }
+        if (cfg_.mem_per_frame < 1) {
+            cout << "mem-per-frame must be at least 1\n"; return false;
+        }
+        if (cfg_.mem_op_ratio < 0.0 || cfg_.mem_op_ratio > 1.0) {
+            cout << "mem-op-ratio must be between 0 and 1\n"; return false;
+        }
+        if (cfg_.tlb_entries < 1) {
+            cout << "tlb-entries must be at least 1\n"; return false;
+        }
+        if (cfg_.min_mem_per_proc < 1 || cfg_.min_mem_per_proc > cfg_.max_mem_per_proc ||
+            cfg_.max_mem_per_proc > cfg_.max_overall_mem) {
+            cout << "min-mem-per-proc and max-mem-per-proc must satisfy 1 <= min <= max <= max-overall-mem\n"; return false;
+        }
+        if (cfg_.memory_snapshot != "binary" && cfg_.memory_snapshot != "text" && cfg_.memory_snapshot != "both") {
+            cout << "memory-snapshot must be 'binary', 'text' or 'both'\n"; return false;
+        }
+        for (const auto& g : cfg_.process_groups) {
+            if (g.second < 1) {
+                cout << "process-groups: group '" << g.first << "' needs at least 1 ticket\n"; return false;
+            }
+        }
+        if (cfg_.deadline_min_ticks > cfg_.deadline_max_ticks ||
+            (cfg_.deadline_max_ticks > 0 && cfg_.deadline_min_ticks < 1)) {
+            cout << "deadline-min-ticks and deadline-max-ticks must satisfy 1 <= min <= max\n"; return false;
+        }
+        if (cfg_.deadline_share < 0.0 || cfg_.deadline_share > 1.0) {
+            cout << "deadline-share must be between 0 and 1\n"; return false;
+        }
+        if (cfg_.edf_density_bound <= 0.0) {
+            cout << "edf-density-bound must be positive\n"; return false;
+        }
+        if (cfg_.overload_policy != "pause" && cfg_.overload_policy != "drop") {
+            cout << "overload-policy must be 'pause' or 'drop'\n"; return false;
+        }
+        if (cfg_.backlog_low > cfg_.backlog_high || cfg_.pending_mem_low > cfg_.pending_mem_high) {
+            cout << "backpressure low watermarks must not exceed the high ones\n"; return false;
+        }
+        if (cfg_.stats_segment.empty() || cfg_.stats_segment.find_first_of("/\\") != string::npos) {
+            cout << "stats-segment must be a plain name (no slashes) or 'off'\n"; return false;
+        }
+        if (cfg_.metrics_target.empty() || cfg_.metrics_target == "unix:") {
+            cout << "metrics-target must be a file path, unix:<socket path> or 'off'\n"; return false;
+        }
+        if (cfg_.metrics_interval_ms < 1) {
+            cout << "metrics-interval-ms must be at least 1\n"; return false;
+        }
+        if (cfg_.program_corpus.empty()) {
+            cout << "program-corpus must be a file path or 'off'\n"; return false;
+        }
+        if (cfg_.batch_submit_max < 1) {
+            cout << "batch-submit-max must be at least 1\n"; return false;
+        }
+        if (cfg_.adaptive_quantum) {
+            if (cfg_.scheduler != "rr") {
+                cout << "adaptive-quantum is only supported with the rr scheduler\n"; return false;
+            }
+            if (cfg_.quantum_min < 1 || cfg_.quantum_min > cfg_.quantum_max) {
+                cout << "quantum-min and quantum-max must satisfy 1 <= min <= max\n"; return false;
+            }
+            if (cfg_.max_switch_overhead <= 0.0 || cfg_.max_switch_overhead >= 1.0) {
+                cout << "max-switch-overhead must be between 0 and 1\n"; return false;
+            }
+        }
 
         return true;
     }
@@ -0,0 +1,170 @@
+﻿#include "Core.h"
+#include "Scheduler.h"
+#include "GlobalState.h"
+#include <iostream>
+
+Core::Core(int id, Scheduler* scheduler, uint64_t delayPerExec)
+    : id_(id), busy_(false), scheduler(scheduler), delayPerExec_(delayPerExec) {
+    for (int op = 0; op < Process::OpcodeCount; ++op) {
+        opcodeCounts_[op].store(0);
+        opcodeSamples_[op].store(0);
+        opcodeSampleNanos_[op].store(0);
+    }
+}
+
+Core::~Core() {
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void Core::stop() {
+    busy_ = false;
+}
+
+bool Core::isBusy() const {
+    return busy_;
+}
+
+bool Core::tryAssign(std::shared_ptr<Process> p, uint64_t quantum, uint64_t migrationPenalty) {
+    if (busy_) return false;
+
+    if (worker_.joinable()) {
+        worker_.join();  // Ensure previous thread is cleanly joined
+    }
+
+    bool warm = isWarmFor(*p);
+    uint64_t warmup = (warm ? 0 : warmupTicks_) + migrationPenalty;
+    (warm ? warmStarts_ : coldStarts_).fetch_add(1);
+
+    runningProcess = p;
+    dispatchSeq_++;
+    if (p->getPid() != lastPid_) {
+        contextSwitches_.fetch_add(1, memory_order_relaxed);
+        lastPid_ = p->getPid();
+    }
+    p->setLastCoreId(id_);
+    p->setLastCoreSeq(dispatchSeq_);
+    sliceStart_ = globalCpuTicks.load();
+    preempt_ = false;
+    busy_ = true;
+
+    try {
+        worker_ = std::thread(&Core::workerLoop, this, p, quantum, warmup);
+    }
+    catch (const std::system_error& e) {
+        std::cerr << "[Core-" << id_ << "] Failed to start thread: " << e.what() << std::endl;
+        busy_ = false;
+        sliceStart_ = NotRunning;
+        runningProcess = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+void Core::workerLoop(std::shared_ptr<Process> p, uint64_t quantum, uint64_t warmup) {
+    uint64_t executed = 0;
+    bool descheduled = false;
+    p->markDispatched(globalCpuTicks.load());
+    EventTracer& tracer = scheduler->tracer();
+    if (tracer.enabled()) {
+        tracer.record(tracer.coreRing(id_), TraceEventType::Dispatch, p->getPid(), id_, globalCpuTicks.load(),
+            static_cast<uint32_t>(quantum > UINT32_MAX ? UINT32_MAX : quantum));
+    }
+
+    // Cold cache: the core is busy refilling state and makes no progress
+    for (uint64_t i = 0; i < warmup && busy_.load() && !preempt_.load(); ++i) {
+        globalCpuTicks.fetch_add(1);
+        scheduler->updateCoreUtilization(id_, 1);
+        p->addCpuTicks(1);
+        warmupTicksSpent_.fetch_add(1);
+    }
+
+    while (busy_.load() && !preempt_.load() && !p->isFinished() && executed < quantum) {
+        if (p->isSleeping()) {
+            if (tracer.enabled()) {
+                uint64_t now = globalCpuTicks.load();
+                uint64_t target = p->getSleepTargetTick();
+                tracer.record(tracer.coreRing(id_), TraceEventType::Sleep, p->getPid(), id_, now,
+                    static_cast<uint32_t>(target > now ? target - now : 0));
+            }
+            // Before the hand-off: the scheduler may wake and redispatch p at once
+            p->markDescheduled(globalCpuTicks.load());
+            descheduled = true;
+            if (scheduler) scheduler->requeueProcess(p);
+            break;
+        }
+
+        Process::Executed ins;
+        bool ran;
+        if (--sampleCountdown_ == 0) {
+            sampleCountdown_ = OpcodeSamplePeriod;
+            auto started = std::chrono::steady_clock::now();
+            ran = p->runOneInstruction(id_, &ins);
+            uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - started).count());
+            if (ins.opcode != 0 && ins.opcode < Process::OpcodeCount) {
+                opcodeSamples_[ins.opcode].fetch_add(1, memory_order_relaxed);
+                opcodeSampleNanos_[ins.opcode].fetch_add(nanos, memory_order_relaxed);
+            }
+        }
+        else {
+            ran = p->runOneInstruction(id_, &ins);
+        }
+        if (ins.opcode != 0 && ins.opcode < Process::OpcodeCount) {
+            opcodeCounts_[ins.opcode].fetch_add(1, memory_order_relaxed);
+            if (ins.inLoop) loopBodyInstructions_.fetch_add(1, memory_order_relaxed);
+            if (ins.iteration) loopIterations_.fetch_add(1, memory_order_relaxed);
+        }
+        if (!ran) break;
+
+        // Tick only if instruction was executed
+        globalCpuTicks.fetch_add(1);
+        scheduler->updateCoreUtilization(id_, 1);  // 1 tick of busy CPU time
+        p->addCpuTicks(1);
+
+        executed++;
+
+        // Apply short artificial delay for debug visibility
+        if (delayPerExec_ == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        else {
+            uint64_t targetTick = globalCpuTicks.load() + delayPerExec_;
+            while (globalCpuTicks.load() < targetTick) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    if (!descheduled) p->markDescheduled(globalCpuTicks.load());
+
+    //  Moved outside of the delay block
+    if (p->isFinished()) {
+        if (tracer.enabled()) {
+            tracer.record(tracer.coreRing(id_), TraceEventType::Finish, p->getPid(), id_, globalCpuTicks.load());
+        }
+        if (scheduler) scheduler->addFinishedProcess(p);
+    }
+    else if (executed >= quantum) {
+        if (tracer.enabled()) {
+            tracer.record(tracer.coreRing(id_), TraceEventType::QuantumExpiry, p->getPid(), id_, globalCpuTicks.load());
+        }
+        if (scheduler) scheduler->requeueProcess(p);
+    }
+    else if (preempt_.load() && busy_.load() && !descheduled) {
+        if (scheduler) scheduler->requeuePreempted(p);
+    }
+
+    uint64_t start = sliceStart_.exchange(NotRunning);
+    if (start != NotRunning) busyTicks_.fetch_add(globalCpuTicks.load() - start);
+    busy_ = false;
+    runningProcess = nullptr;
+}
+
+uint64_t Core::getBusyTicks(uint64_t now) const {
+    uint64_t start = sliceStart_.load();
+    uint64_t done = busyTicks_.load();
+    return done + (start != NotRunning && now > start ? now - start : 0);
+}
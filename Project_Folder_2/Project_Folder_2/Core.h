@@ -0,0 +1,109 @@
+// Core.h
+/*
+* CORE OVERVIEW
+    - Tracks whether it's busy or free
+    - Can be assigned a process by Scheduler
+    - Runs process instructions by calling p->runQuantum(quantum)
+    - Works for both RR and FCFS (based on quantum value)
+    - Models cache warmth: a process is warm on the core it last ran on until
+      the core has started more than warmWindow other dispatches; a cold start
+      costs warmupTicks busy ticks before the first instruction
+*/
+#pragma once
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <functional>
+#include <chrono> // For sleep_for
+#include "Process.h"
+#include "GlobalState.h" // Include for globalCpuTicks
+using namespace std;
+
+// Forward declare Scheduler to avoid circular include
+class Scheduler;
+
+class Core {
+public:
+    Core(int id, Scheduler* scheduler, uint64_t delayPerExec);  // inject Scheduler reference and delay
+    ~Core();
+
+    int id_;
+    bool isBusy() const;
+
+    // Called by Scheduler to assign a Process. migrationPenalty adds busy
+    // ticks before the first instruction, on top of any cold-start cost.
+    bool tryAssign(shared_ptr<Process> p, uint64_t quantum, uint64_t migrationPenalty = 0);
+
+    // Get the currently running process (for screen -ls/report-util)
+    shared_ptr<Process> getRunningProcess() const {
+        // Return a copy of the shared_ptr if busy, nullptr otherwise
+        return busy_ ? runningProcess : nullptr;
+    }
+
+    void stop();
+    // Ends the running slice after the current instruction and hands the
+    // process back to the scheduler (see Scheduler::requeuePreempted)
+    void preempt() { preempt_ = true; }
+
+    void setCacheModel(uint64_t warmupTicks, uint64_t warmWindow) {
+        warmupTicks_ = warmupTicks;
+        warmWindow_ = warmWindow;
+    }
+    // True if p would start warm here (see the overview above)
+    bool isWarmFor(const Process& p) const {
+        return p.getLastCoreId() == id_ && dispatchSeq_ - p.getLastCoreSeq() <= warmWindow_;
+    }
+    uint64_t getColdStarts() const { return coldStarts_.load(); }
+    uint64_t getWarmStarts() const { return warmStarts_.load(); }
+    uint64_t getWarmupTicksSpent() const { return warmupTicksSpent_.load(); }
+
+    // Global ticks this core has spent busy up to now, the running slice included
+    uint64_t getBusyTicks(uint64_t now) const;
+
+    // Instructions this core has executed with the given opcode
+    uint64_t getInstructionCount(int opcode) const { return opcodeCounts_[opcode].load(memory_order_relaxed); }
+    // Of those, how many ran inside a FOR body, and the loop passes finished
+    uint64_t getLoopBodyInstructions() const { return loopBodyInstructions_.load(memory_order_relaxed); }
+    uint64_t getLoopIterations() const { return loopIterations_.load(memory_order_relaxed); }
+    // One instruction in OpcodeSamplePeriod is timed; these are the timed
+    // ones per opcode and their total steady-clock nanoseconds
+    static const uint64_t OpcodeSamplePeriod = 64;
+    uint64_t getOpcodeSamples(int opcode) const { return opcodeSamples_[opcode].load(memory_order_relaxed); }
+    uint64_t getOpcodeSampleNanos(int opcode) const { return opcodeSampleNanos_[opcode].load(memory_order_relaxed); }
+    // Dispatches that put a different process on this core than the last one
+    uint64_t getContextSwitches() const { return contextSwitches_.load(memory_order_relaxed); }
+
+
+private:
+    void workerLoop(shared_ptr<Process> p, uint64_t quantum, uint64_t warmup);
+
+    atomic<bool> busy_;
+    atomic<bool> preempt_{ false };
+    thread worker_;
+    shared_ptr<Process> runningProcess; // The process currently assigned to this core
+
+    Scheduler* scheduler;  // to notify Scheduler if quantum expires or process finishes/sleeps
+    uint64_t delayPerExec_; // Delay in CPU ticks per instruction execution
+
+    uint64_t warmupTicks_ = 0;
+    uint64_t warmWindow_ = 0;
+    uint64_t dispatchSeq_ = 0;  // dispatches started on this core
+    atomic<uint64_t> coldStarts_{ 0 };
+    atomic<uint64_t> warmStarts_{ 0 };
+    atomic<uint64_t> warmupTicksSpent_{ 0 };
+
+    static const uint64_t NotRunning = UINT64_MAX;
+    atomic<uint64_t> busyTicks_{ 0 };             // finished slices
+    atomic<uint64_t> sliceStart_{ NotRunning };   // global tick the running slice started
+
+    // Written only by this core's worker (opcodes) or the scheduler thread
+    atomic<uint64_t> opcodeCounts_[Process::OpcodeCount];
+    atomic<uint64_t> loopBodyInstructions_{ 0 };
+    atomic<uint64_t> loopIterations_{ 0 };
+    atomic<uint64_t> opcodeSamples_[Process::OpcodeCount];
+    atomic<uint64_t> opcodeSampleNanos_[Process::OpcodeCount];
+    uint64_t sampleCountdown_ = OpcodeSamplePeriod;   // one worker at a time
+    atomic<uint64_t> contextSwitches_{ 0 };
+    int lastPid_ = -1;
+};
\ No newline at end of file
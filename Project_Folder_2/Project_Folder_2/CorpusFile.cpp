@@ -0,0 +1,141 @@
+#include "CorpusFile.h"
+#include <cstddef>
+#include <cstring>
+
+#include "PackedCodec.h"
+
+namespace {
+const char CorpusMagic[8] = { 'C', 'S', 'C', 'O', 'R', 'P', 'U', 'S' };
+const uint32_t CorpusVersion = 1;
+}
+
+bool CorpusWriter::start(const std::string& path, std::string& error) {
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        error = "cannot create " + path;
+        return false;
+    }
+    // Placeholder; finish() writes the real header once the counts are known
+    CorpusFileHeader header{};
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    names_ = NameTable();
+    table_.clear();
+    instructions_ = 0;
+    return true;
+}
+
+void CorpusWriter::add(const Process& p) {
+    // Copy the bytecode, moving its names into the corpus-wide table
+    const PackedInstruction* code = p.getCode();
+    size_t count = p.getTotalInstructions();
+    remap_.clear();
+    if (p.getProgramImage()) {
+        for (const auto& name : p.getProgramImage()->names) remap_.push_back(names_.intern(name));
+    }
+    code_.assign(code, code + count);
+    for (auto& ins : code_) {
+        for (size_t a = 0; a < PackedWriter::storedOperands(ins); ++a) {
+            if (!operandIsName(ins.opcode, a, ins.args[a])) continue;
+            ins.args[a] = remap_[ins.args[a] & ~OperandVariable] | (ins.args[a] & OperandVariable);
+        }
+    }
+    int memorySize = p.getMemorySize() > 0 ? p.getMemorySize() : 0;
+    out_.write(reinterpret_cast<const char*>(code_.data()),
+        static_cast<std::streamsize>(code_.size() * sizeof(PackedInstruction)));
+    table_.push_back({ instructions_, static_cast<uint32_t>(code_.size()), memorySize });
+    instructions_ += code_.size();
+}
+
+bool CorpusWriter::finish(std::string& error) {
+    CorpusFileHeader header{};
+    std::memcpy(header.magic, CorpusMagic, sizeof(header.magic));
+    header.version = CorpusVersion;
+    header.programs = table_.size();
+    header.instructions = instructions_;
+    header.names = names_.names.size();
+    header.codeOffset = sizeof(header);
+    header.tableOffset = header.codeOffset + instructions_ * sizeof(PackedInstruction);
+    header.namesOffset = header.tableOffset + table_.size() * sizeof(CorpusProgramEntry);
+
+    out_.write(reinterpret_cast<const char*>(table_.data()),
+        static_cast<std::streamsize>(table_.size() * sizeof(CorpusProgramEntry)));
+    PackedWriter names;
+    for (const auto& name : names_.names) names.putString(name);
+    out_.write(names.buffer().data(), static_cast<std::streamsize>(names.buffer().size()));
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    bool ok = static_cast<bool>(out_);
+    out_.close();
+    if (!ok) error = "write failed";
+    return ok;
+}
+
+bool CorpusFile::open(const std::string& path, std::string& error) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(path, error)) return false;
+
+    CorpusFileHeader header{};
+    size_t size = file->size();
+    if (size < sizeof(header)) {
+        error = path + " is not a program corpus";
+        return false;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, CorpusMagic, sizeof(header.magic)) != 0) {
+        error = path + " is not a program corpus";
+        return false;
+    }
+    if (header.version != CorpusVersion) {
+        error = path + " has unsupported corpus version " + std::to_string(header.version);
+        return false;
+    }
+    // The sections must follow each other inside the file, aligned for
+    // direct access from the mapping
+    if (header.codeOffset < sizeof(header) || header.codeOffset % alignof(PackedInstruction) != 0
+        || header.codeOffset > size
+        || header.instructions > (size - header.codeOffset) / sizeof(PackedInstruction)
+        || header.tableOffset != header.codeOffset + header.instructions * sizeof(PackedInstruction)
+        || header.tableOffset % alignof(CorpusProgramEntry) != 0
+        || header.programs > (size - header.tableOffset) / sizeof(CorpusProgramEntry)
+        || header.namesOffset != header.tableOffset + header.programs * sizeof(CorpusProgramEntry)) {
+        error = path + " is damaged: its sections do not fit the file";
+        return false;
+    }
+
+    auto image = std::make_shared<ProgramImage>();
+    PackedReader reader(file->data() + header.namesOffset, size - header.namesOffset);
+    if (header.names > size - header.namesOffset) {
+        error = path + " is damaged: bad name table";
+        return false;
+    }
+    image->names.resize(static_cast<size_t>(header.names));
+    for (auto& name : image->names) {
+        if (!reader.getString(name)) {
+            error = path + " is damaged: bad name table";
+            return false;
+        }
+    }
+
+    code_ = reinterpret_cast<const PackedInstruction*>(file->data() + header.codeOffset);
+    table_ = reinterpret_cast<const CorpusProgramEntry*>(file->data() + header.tableOffset);
+    programs_ = header.programs;
+    instructions_ = header.instructions;
+    image->file = std::move(file);
+    image_ = std::move(image);
+    path_ = path;
+    return true;
+}
+
+// Checked per program rather than at open, so opening touches no code pages
+bool CorpusFile::program(uint64_t index, const PackedInstruction*& code, size_t& count, int& memorySize) const {
+    if (index >= programs_) return false;
+    const CorpusProgramEntry& entry = table_[index];
+    if (entry.firstInstruction > instructions_ || entry.instructionCount > instructions_ - entry.firstInstruction) {
+        return false;
+    }
+    code = code_ + entry.firstInstruction;
+    count = entry.instructionCount;
+    if (!bytecodeFits(code, count, image_->names.size())) return false;
+    memorySize = entry.memorySize;
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Bytecode.h"
+#include "MappedFile.h"
+#include "Process.h"
+
+// Program corpus: programs stored as ready-to-run bytecode, so a mapped file
+// can be executed in place. Laid out as
+//   header
+//   code       PackedInstruction[instructions], every program back to back
+//   table      CorpusProgramEntry[programs]
+//   names      the variable names, encoded with PackedCodec strings
+// All programs share one name table. Integers are in the byte order of the
+// machine that wrote the file.
+struct CorpusFileHeader {
+    char     magic[8];      // "CSCORPUS"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t programs;
+    uint64_t instructions;
+    uint64_t names;
+    uint64_t codeOffset;
+    uint64_t tableOffset;
+    uint64_t namesOffset;
+};
+static_assert(sizeof(CorpusFileHeader) == 64, "CorpusFileHeader must stay 64 bytes");
+
+struct CorpusProgramEntry {
+    uint64_t firstInstruction;
+    uint32_t instructionCount;
+    int32_t  memorySize;        // 0: drawn from the configured range
+};
+static_assert(sizeof(CorpusProgramEntry) == 16, "CorpusProgramEntry must stay 16 bytes");
+
+// Writes a corpus front to back; the code is streamed out as programs are
+// added, the table and names follow in finish(). Not thread-safe.
+class CorpusWriter {
+public:
+    bool start(const std::string& path, std::string& error);
+    // Appends p's program and memory size
+    void add(const Process& p);
+    // Returns false with error set if anything failed to write
+    bool finish(std::string& error);
+    uint64_t programCount() const { return table_.size(); }
+    uint64_t instructionCount() const { return instructions_; }
+
+private:
+    std::ofstream out_;
+    NameTable names_;
+    std::vector<CorpusProgramEntry> table_;
+    std::vector<PackedInstruction> code_;   // one program, reused
+    std::vector<uint32_t> remap_;           // program name index -> corpus index
+    uint64_t instructions_ = 0;
+};
+
+// A corpus mapped read-only. Opening reads only the header and the name
+// table; a program's pages are faulted in when a process first runs it.
+// Thread-safe once open.
+class CorpusFile {
+public:
+    // Returns false with error set if the file is missing or not a corpus
+    bool open(const std::string& path, std::string& error);
+
+    const std::string& path() const { return path_; }
+    uint64_t programCount() const { return programs_; }
+    uint64_t instructionCount() const { return instructions_; }
+    // Shared by every program; keeps the mapping alive
+    const std::shared_ptr<const ProgramImage>& image() const { return image_; }
+
+    // Locates program index in the mapping. Returns false if its table entry
+    // or an operand points outside the file, or an instruction does not fit
+    // the packed encoding.
+    bool program(uint64_t index, const PackedInstruction*& code, size_t& count, int& memorySize) const;
+
+private:
+    std::string path_;
+    std::shared_ptr<const ProgramImage> image_;
+    const PackedInstruction* code_ = nullptr;
+    const CorpusProgramEntry* table_ = nullptr;
+    uint64_t programs_ = 0;
+    uint64_t instructions_ = 0;
+};
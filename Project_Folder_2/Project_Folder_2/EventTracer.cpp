@@ -0,0 +1,117 @@
+#include "EventTracer.h"
+#include <cstring>
+
+EventTracer::EventTracer(int cores) : cores_(cores) {
+    for (int i = 0; i < cores + 2; ++i) rings_.push_back(std::make_unique<Ring>());
+}
+
+EventTracer::~EventTracer() {
+    uint64_t dropped;
+    stop(dropped);
+}
+
+namespace {
+uint64_t steadyNanosNow() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+}
+
+// Announced in inFlight before enabled_ is checked again, and stop() clears
+// enabled_ before it waits for inFlight to drop to 0 (both sequentially
+// consistent), so either this record sees the tracer stopped or stop() sees
+// it in flight and waits for it to finish
+void EventTracer::record(size_t ring, TraceEventType type, int pid, int core, uint64_t tick, uint32_t arg) {
+    Ring& r = *rings_[ring];
+    r.inFlight.fetch_add(1);
+    if (!enabled_.load()) {
+        r.inFlight.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+    bool serialized = ring == arrivalRing();
+    if (serialized) {
+        while (arrivalLock_.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+    }
+    uint64_t head = r.head.load(std::memory_order_relaxed);
+    if (head - r.tail.load(std::memory_order_acquire) >= RingCapacity) {
+        r.dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        TraceEvent& e = r.events[head & (RingCapacity - 1)];
+        e.nanos = steadyNanosNow() - startNanos_.load(std::memory_order_relaxed);
+        e.tick = tick;
+        e.pid = pid;
+        e.arg = arg;
+        e.core = core < 0 ? TraceNoCore : static_cast<uint16_t>(core);
+        e.type = static_cast<uint8_t>(type);
+        std::memset(e.reserved, 0, sizeof(e.reserved));
+        r.head.store(head + 1, std::memory_order_release);
+    }
+    if (serialized) arrivalLock_.clear(std::memory_order_release);
+    r.inFlight.fetch_sub(1, std::memory_order_release);
+}
+
+// Consumer side; only the writer thread, or start/stop while it is not running
+size_t EventTracer::drain(bool write) {
+    size_t count = 0;
+    for (auto& ring : rings_) {
+        Ring& r = *ring;
+        uint64_t tail = r.tail.load(std::memory_order_relaxed);
+        uint64_t head = r.head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail, ++count) {
+            if (write) {
+                out_.write(reinterpret_cast<const char*>(&r.events[tail & (RingCapacity - 1)]), sizeof(TraceEvent));
+            }
+        }
+        r.tail.store(tail, std::memory_order_release);
+    }
+    return count;
+}
+
+void EventTracer::writerLoop() {
+    while (writerRunning_.load()) {
+        written_ += drain(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+bool EventTracer::start(const std::string& path) {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    if (enabled_.load()) return false;
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) return false;
+
+    TraceFileHeader header{};
+    std::memcpy(header.magic, "CSTRACE1", 8);
+    header.version = 1;
+    header.cores = static_cast<uint32_t>(cores_);
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    drain(false);   // leftovers of an earlier trace
+    written_ = 0;
+    droppedAtStart_ = 0;
+    for (const auto& r : rings_) droppedAtStart_ += r->dropped.load();
+    startNanos_.store(steadyNanosNow(), std::memory_order_relaxed);
+    writerRunning_ = true;
+    writer_ = std::thread(&EventTracer::writerLoop, this);
+    enabled_ = true;
+    return true;
+}
+
+uint64_t EventTracer::stop(uint64_t& dropped) {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    dropped = 0;
+    if (!enabled_.load()) return 0;
+    enabled_ = false;
+    writerRunning_ = false;
+    if (writer_.joinable()) writer_.join();
+    // Producers that saw the tracer enabled may still be finishing a record
+    for (const auto& r : rings_) {
+        while (r->inFlight.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+    }
+    written_ += drain(true);
+    out_.close();
+    for (const auto& r : rings_) dropped += r->dropped.load();
+    dropped -= droppedAtStart_;
+    return written_;
+}
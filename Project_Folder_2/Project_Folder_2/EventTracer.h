@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Kinds of scheduler trace events
+enum class TraceEventType : uint8_t {
+    Dispatch = 1,       // process started on core; arg holds its quantum
+    QuantumExpiry = 2,  // process used its quantum and was requeued
+    Sleep = 3,          // process went to sleep; arg holds the ticks it sleeps
+    Wake = 4,           // sleeping process became ready again
+    MemoryDefer = 5,    // arrival had to wait for memory
+    Admit = 6,          // deferred arrival got memory; arg holds the ticks it waited
+    Finish = 7          // process finished on core
+};
+
+// Fixed-size trace record
+struct TraceEvent {
+    uint64_t nanos;     // steady-clock time since trace-start
+    uint64_t tick;      // globalCpuTicks
+    int32_t  pid;
+    uint32_t arg;
+    uint16_t core;      // TraceNoCore for events not tied to a core
+    uint8_t  type;
+    uint8_t  reserved[5];
+};
+static_assert(sizeof(TraceEvent) == 32, "TraceEvent must stay 32 bytes");
+
+const uint16_t TraceNoCore = 0xFFFF;
+
+struct TraceFileHeader {
+    char     magic[8];  // "CSTRACE1"
+    uint32_t version;
+    uint32_t cores;
+};
+static_assert(sizeof(TraceFileHeader) == 16, "TraceFileHeader must stay 16 bytes");
+
+// Scheduler event tracer. Every producer thread owns a single-producer
+// single-consumer ring: one per core (written by the core's worker), one for
+// the scheduler thread and one for arrivals. A writer thread drains the rings
+// to a binary file while tracing is on; a full ring drops events and counts
+// them. Call sites check enabled() first, so a disabled tracer costs one
+// plain load (an acquire load needs no fence on x86) and a branch.
+class EventTracer {
+public:
+    static const size_t RingCapacity = 1 << 14;   // events, power of two
+
+    explicit EventTracer(int cores);
+    ~EventTracer();
+
+    bool enabled() const { return enabled_.load(std::memory_order_acquire); }
+
+    // Ring of a core, of the scheduler thread, or of the arrival path
+    size_t coreRing(int core) const { return static_cast<size_t>(core); }
+    size_t schedulerRing() const { return static_cast<size_t>(cores_); }
+    size_t arrivalRing() const { return static_cast<size_t>(cores_) + 1; }
+
+    // Only the thread that owns ring may call this, except for the arrival
+    // ring, which is serialized because the generator and console both submit.
+    // Does nothing if tracing stopped after the caller checked enabled().
+    void record(size_t ring, TraceEventType type, int pid, int core, uint64_t tick, uint32_t arg = 0);
+
+    bool start(const std::string& path);
+    // Returns the number of events written; dropped is set to those lost to full rings
+    uint64_t stop(uint64_t& dropped);
+
+private:
+    struct Ring {
+        std::unique_ptr<TraceEvent[]> events{ new TraceEvent[RingCapacity] };
+        std::atomic<uint64_t> head{ 0 };   // next slot the producer writes
+        std::atomic<uint64_t> tail{ 0 };   // next slot the consumer reads
+        std::atomic<uint64_t> dropped{ 0 };
+        std::atomic<int> inFlight{ 0 };    // producers inside record(); stop() waits for 0
+    };
+
+    void writerLoop();
+    size_t drain(bool write);
+
+    int cores_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+    std::atomic_flag arrivalLock_ = ATOMIC_FLAG_INIT;
+    std::atomic<bool> enabled_{ false };
+    std::atomic<uint64_t> startNanos_{ 0 };    // steady clock at trace-start, read by producers
+
+    std::mutex controlMutex_;   // start/stop
+    std::ofstream out_;
+    std::thread writer_;
+    std::atomic<bool> writerRunning_{ false };
+    uint64_t written_ = 0;
+    uint64_t droppedAtStart_ = 0;
+};
@@ -0,0 +1,90 @@
+// IndexedMinHeap.h
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Binary min-heap of integer ids with a position index, so the key of an id
+// already in the heap can be changed or removed in O(log n). Not thread-safe.
+template <typename Key>
+class IndexedMinHeap {
+public:
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+    bool contains(int id) const { return pos_.count(id) > 0; }
+
+    const Key& topKey() const { return heap_.front().first; }
+    int topId() const { return heap_.front().second; }
+
+    // Inserts id, or changes its key if it is already present
+    void pushOrUpdate(int id, const Key& key) {
+        auto it = pos_.find(id);
+        if (it == pos_.end()) {
+            heap_.emplace_back(key, id);
+            pos_[id] = heap_.size() - 1;
+            siftUp(heap_.size() - 1);
+            return;
+        }
+        size_t i = it->second;
+        heap_[i].first = key;
+        siftUp(i);
+        siftDown(pos_[id]);
+    }
+
+    int pop() {
+        int id = heap_.front().second;
+        erase(id);
+        return id;
+    }
+
+    void erase(int id) {
+        auto it = pos_.find(id);
+        if (it == pos_.end()) return;
+        size_t i = it->second;
+        size_t last = heap_.size() - 1;
+        if (i != last) swapNodes(i, last);
+        heap_.pop_back();
+        pos_.erase(id);
+        if (i < heap_.size()) {
+            int moved = heap_[i].second;
+            siftUp(i);
+            siftDown(pos_[moved]);
+        }
+    }
+
+    void clear() {
+        heap_.clear();
+        pos_.clear();
+    }
+
+private:
+    void swapNodes(size_t a, size_t b) {
+        std::swap(heap_[a], heap_[b]);
+        pos_[heap_[a].second] = a;
+        pos_[heap_[b].second] = b;
+    }
+
+    void siftUp(size_t i) {
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!(heap_[i].first < heap_[parent].first)) break;
+            swapNodes(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(size_t i) {
+        for (;;) {
+            size_t left = 2 * i + 1, right = left + 1, smallest = i;
+            if (left < heap_.size() && heap_[left].first < heap_[smallest].first) smallest = left;
+            if (right < heap_.size() && heap_[right].first < heap_[smallest].first) smallest = right;
+            if (smallest == i) break;
+            swapNodes(i, smallest);
+            i = smallest;
+        }
+    }
+
+    std::vector<std::pair<Key, int>> heap_;
+    std::unordered_map<int, size_t> pos_;
+};
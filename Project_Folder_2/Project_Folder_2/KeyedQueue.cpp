@@ -0,0 +1,24 @@
+#include "KeyedQueue.h"
+
+void KeyedQueue::push(std::shared_ptr<Process> p) {
+    uint64_t key = key_(*p);
+    std::lock_guard<std::mutex> lock(mutex_);
+    int pid = p->getPid();
+    heap_.pushOrUpdate(pid, Key(key, nextSeq_++));
+    byPid_[pid] = std::move(p);
+}
+
+bool KeyedQueue::try_pop(std::shared_ptr<Process>& p) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (heap_.empty()) return false;
+    int pid = heap_.pop();
+    auto it = byPid_.find(pid);
+    p = std::move(it->second);
+    byPid_.erase(it);
+    return true;
+}
+
+size_t KeyedQueue::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return heap_.size();
+}
@@ -0,0 +1,35 @@
+// KeyedQueue.h
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "IndexedMinHeap.h"
+#include "Process.h"
+
+// Thread-safe ready queue that pops the process with the smallest key, ties
+// broken by arrival order. The key is read once per push, so a requeue
+// re-keys the process. Backs "sjf"/"srtf" (remaining work) and "edf"
+// (absolute deadline).
+class KeyedQueue {
+public:
+    using KeyFn = uint64_t (*)(const Process&);
+
+    explicit KeyedQueue(KeyFn key) : key_(key) {}
+
+    // Queues p, or re-keys it if it is already queued; O(log n)
+    void push(std::shared_ptr<Process> p);
+    bool try_pop(std::shared_ptr<Process>& p);
+    size_t size();
+
+private:
+    using Key = std::pair<uint64_t, uint64_t>;  // (key, sequence)
+
+    KeyFn key_;
+    std::mutex mutex_;
+    IndexedMinHeap<Key> heap_;
+    std::unordered_map<int, std::shared_ptr<Process>> byPid_;
+    uint64_t nextSeq_ = 0;
+};
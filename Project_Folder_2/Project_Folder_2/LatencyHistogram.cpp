@@ -0,0 +1,58 @@
+#include "LatencyHistogram.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+int highestSetBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+}
+
+LatencyHistogram::LatencyHistogram()
+    : counts_(indexOf(UINT64_MAX) + 1, 0) {
+}
+
+// Values with their top bit at position b >= 7 are shifted right by b - 6,
+// leaving 64..127; each shift amount gets its own 64 buckets after the first 128
+size_t LatencyHistogram::indexOf(uint64_t value) {
+    if (value < SubBuckets) return static_cast<size_t>(value);
+    int shift = highestSetBit(value) - (SubBucketBits - 1);
+    return static_cast<size_t>(SubBuckets + (shift - 1) * HalfSubBuckets + ((value >> shift) - HalfSubBuckets));
+}
+
+uint64_t LatencyHistogram::highestValueAt(size_t index) {
+    if (index < SubBuckets) return index;
+    uint64_t shift = (index - SubBuckets) / HalfSubBuckets + 1;
+    uint64_t sub = (index - SubBuckets) % HalfSubBuckets + HalfSubBuckets;
+    uint64_t lowest = sub << shift;
+    return lowest + ((1ULL << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    counts_[indexOf(value)]++;
+    count_++;
+    if (value > max_) max_ = value;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+    if (count_ == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(fraction * count_ + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > count_) rank = count_;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts_.size(); ++i) {
+        seen += counts_[i];
+        if (seen >= rank) {
+            uint64_t value = highestValueAt(i);
+            return value < max_ ? value : max_;
+        }
+    }
+    return max_;
+}
@@ -0,0 +1,34 @@
+// LatencyHistogram.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Log-linear histogram in the style of HdrHistogram. Values below 128 get a
+// bucket each; above that, every power of two is split into 64 buckets, so
+// a reported value is within 1/64 (about 1.6%) of the recorded one, over
+// the whole uint64_t range, in under 4k buckets. Not thread-safe.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t value);
+
+    uint64_t count() const { return count_; }
+    uint64_t max() const { return max_; }
+    // Value at or below which fraction of the samples lie, reported as the
+    // highest value of its bucket (capped at max()); 0 when empty
+    uint64_t percentile(double fraction) const;
+
+private:
+    static const int SubBucketBits = 7;
+    static const uint64_t SubBuckets = 1ULL << SubBucketBits;   // 128
+    static const uint64_t HalfSubBuckets = SubBuckets / 2;      // 64
+
+    static size_t indexOf(uint64_t value);
+    static uint64_t highestValueAt(size_t index);
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    uint64_t max_ = 0;
+};
@@ -0,0 +1,37 @@
+// MappedFile.h
+#pragma once
+#include <cstddef>
+#include <string>
+
+// A whole file mapped read-only. Pages are faulted in by the OS as they are
+// touched, so opening a large file costs no more than opening a small one.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false with error set if the file cannot be opened or mapped;
+    // an empty file opens with size() 0 and no mapping
+    bool open(const std::string& path, std::string& error);
+    void close();
+
+    bool isOpen() const { return open_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    bool open_ = false;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+// Moves from over to in one step. Use it to rewrite a file that may be
+// mapped: truncating it in place would pull the pages from under the
+// mapping, while a replaced file stays alive until it is unmapped.
+bool replaceFile(const std::string& from, const std::string& to);
@@ -0,0 +1,116 @@
+#include "MemoryEventLog.h"
+#include "MemoryManager.h"
+#include <cstring>
+#include <algorithm>
+#include <iomanip>
+
+MemoryEventLog::MemoryEventLog(const std::string& path, int maxMemory, int memPerProc, int memPerFrame,
+    int shardCount, uint32_t checkpointInterval)
+    : out_(path, std::ios::binary | std::ios::trunc),
+    checkpointInterval_(checkpointInterval == 0 ? 1 : checkpointInterval) {
+    if (!out_) return;
+
+    MemoryLogHeader header{};
+    std::memcpy(header.magic, "CSMEMLOG", sizeof(header.magic));
+    header.version = 1;
+    header.maxMemory = maxMemory;
+    header.memPerProc = memPerProc;
+    header.memPerFrame = memPerFrame;
+    header.checkpointInterval = checkpointInterval_;
+    header.shardCount = shardCount;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+MemoryEventLog::~MemoryEventLog() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (out_) out_.flush();
+}
+
+// Caller holds mutex_
+void MemoryEventLog::append(MemoryEventType type, int pid, int start, int end, uint64_t tick, int64_t wallTime) {
+    if (!out_) return;
+    // Ticks are read before the lock is taken, so keep them non-decreasing
+    if (tick < lastTick_) tick = lastTick_;
+    lastTick_ = tick;
+
+    MemoryEventRecord rec{};
+    rec.type = static_cast<uint8_t>(type);
+    rec.pid = pid;
+    rec.start = start;
+    rec.end = end;
+    rec.tick = tick;
+    rec.wallTime = wallTime;
+    out_.write(reinterpret_cast<const char*>(&rec), sizeof(rec));
+}
+
+void MemoryEventLog::logAllocate(int pid, int start, int end, uint64_t tick) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(MemoryEventType::Allocate, pid, start, end, tick, 0);
+}
+
+void MemoryEventLog::logFree(int pid, int start, int end, uint64_t tick) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(MemoryEventType::Free, pid, start, end, tick, 0);
+}
+
+void MemoryEventLog::logQuantum(int quantumIndex, uint64_t tick, const std::vector<MemoryBlock>& blocks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    append(MemoryEventType::Quantum, quantumIndex, 0, 0, tick, static_cast<int64_t>(time(nullptr)));
+
+    if (++quantaSinceCheckpoint_ >= checkpointInterval_) {
+        writeCheckpoint(tick, blocks);
+        quantaSinceCheckpoint_ = 0;
+        out_.flush();
+    }
+}
+
+void MemoryEventLog::writeCheckpoint(uint64_t tick, const std::vector<MemoryBlock>& blocks) {
+    int used = 0;
+    for (const auto& b : blocks) if (b.pid != -1) used++;
+
+    append(MemoryEventType::Checkpoint, used, 0, 0, tick, static_cast<int64_t>(time(nullptr)));
+    for (const auto& b : blocks) {
+        if (b.pid != -1)
+            append(MemoryEventType::Block, b.pid, b.start, b.end, tick, 0);
+    }
+}
+
+int shardBaseOf(int address, int maxMemory, int memPerFrame, int shardCount) {
+    if (shardCount < 1) shardCount = 1;
+    int shardSize = maxMemory / shardCount / memPerFrame * memPerFrame;
+    if (shardSize == 0) return 0;
+    int index = std::min(address / shardSize, shardCount - 1);
+    return index * shardSize;
+}
+
+void renderMemoryStamp(std::ostream& out, const std::vector<MemoryBlock>& blocks,
+    int maxMemory, int memPerProc, time_t timestamp) {
+    std::tm tm;
+#ifdef _WIN32
+    localtime_s(&tm, &timestamp);
+#else
+    localtime_r(&timestamp, &tm);
+#endif
+
+    out << "Timestamp: (" << std::put_time(&tm, "%m/%d/%Y %I:%M:%S%p") << ")\n";
+
+    int procCount = 0;
+    for (auto& b : blocks) if (b.pid != -1) procCount++;
+    out << "Number of processes in memory: " << procCount << "\n";
+
+    int frag = 0;
+    for (auto& b : blocks)
+        if (b.pid == -1 && b.size() < memPerProc)
+            frag += b.size();
+    out << "Total external fragmentation in KB: " << frag / 1024 << "\n\n";
+
+    out << "----end---- = " << maxMemory << "\n\n";
+    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+        if (it->pid != -1) {
+            out << it->end << "\n";
+            out << "P" << it->pid << "\n";
+            out << it->start << "\n\n";
+        }
+    }
+    out << "----start---- = 0\n";
+}
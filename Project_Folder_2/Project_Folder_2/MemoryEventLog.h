@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct MemoryBlock;
+
+// Kinds of records in the memory event log
+enum class MemoryEventType : uint8_t {
+    Allocate = 1,   // pid was given [start, end)
+    Free = 2,       // pid released [start, end)
+    Quantum = 3,    // quantum boundary; pid holds the quantum index
+    Checkpoint = 4, // full layout follows; pid holds the number of Block records
+    Block = 5       // one allocated block of a checkpoint
+};
+
+// Fixed-size record, appended in tick order
+struct MemoryEventRecord {
+    uint8_t  type;
+    uint8_t  reserved[3];
+    int32_t  pid;
+    int32_t  start;
+    int32_t  end;
+    uint64_t tick;
+    int64_t  wallTime;
+};
+static_assert(sizeof(MemoryEventRecord) == 32, "MemoryEventRecord must stay 32 bytes");
+
+struct MemoryLogHeader {
+    char     magic[8];  // "CSMEMLOG"
+    uint32_t version;
+    int32_t  maxMemory;
+    int32_t  memPerProc;
+    int32_t  memPerFrame;
+    uint32_t checkpointInterval;
+    int32_t  shardCount;  // free space never spans a shard boundary
+};
+static_assert(sizeof(MemoryLogHeader) == 32, "MemoryLogHeader must stay 32 bytes");
+
+// Append-only binary log of allocator changes with periodic full checkpoints.
+// Thread-safe. Record ticks never decrease, so readers can binary search them.
+class MemoryEventLog {
+public:
+    MemoryEventLog(const std::string& path, int maxMemory, int memPerProc, int memPerFrame,
+        int shardCount, uint32_t checkpointInterval);
+    ~MemoryEventLog();
+
+    bool isOpen() const { return out_.is_open(); }
+
+    void logAllocate(int pid, int start, int end, uint64_t tick);
+    void logFree(int pid, int start, int end, uint64_t tick);
+
+    // Records a quantum boundary. Every checkpointInterval boundaries a
+    // checkpoint of the allocated blocks is written and the file is flushed.
+    void logQuantum(int quantumIndex, uint64_t tick, const std::vector<MemoryBlock>& blocks);
+
+private:
+    void append(MemoryEventType type, int pid, int start, int end, uint64_t tick, int64_t wallTime);
+    void writeCheckpoint(uint64_t tick, const std::vector<MemoryBlock>& blocks);
+
+    std::mutex mutex_;
+    std::ofstream out_;
+    uint64_t lastTick_ = 0;
+    uint32_t checkpointInterval_;
+    uint32_t quantaSinceCheckpoint_ = 0;
+};
+
+// Start of the shard containing the given address, for a manager with
+// shardCount shards laid out as MemoryManager does
+int shardBaseOf(int address, int maxMemory, int memPerFrame, int shardCount);
+
+// Writes a layout in the memory_stamp_XX.txt format. Free blocks are only
+// used for the external fragmentation figure.
+void renderMemoryStamp(std::ostream& out, const std::vector<MemoryBlock>& blocks,
+    int maxMemory, int memPerProc, time_t timestamp);
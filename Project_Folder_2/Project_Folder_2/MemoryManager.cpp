@@ -1,47 +1,131 @@
 #include "MemoryManager.h"
+#include "GlobalState.h"
 #include <fstream>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <algorithm>
+#include <cstring>
 
-MemoryManager::MemoryManager(int maxMemory, int memPerProc, int memPerFrame)
+MemoryManager::MemoryManager(int maxMemory, int memPerProc, int memPerFrame, int numShards)
     : maxMemory(maxMemory), memPerProc(memPerProc), memPerFrame(memPerFrame) {
-    blocks.push_back({ 0, maxMemory, -1 });
+    if (numShards < 1) numShards = 1;
+
+    // Frame-aligned shard boundaries; the last shard takes the remainder
+    int shardSize = maxMemory / numShards / memPerFrame * memPerFrame;
+    if (shardSize == 0) {
+        numShards = 1;
+        shardSize = maxMemory;
+    }
+    for (int i = 0; i < numShards; ++i) {
+        auto shard = std::make_unique<MemoryShard>();
+        shard->base = i * shardSize;
+        shard->limit = (i == numShards - 1) ? maxMemory : shard->base + shardSize;
+        shard->blocks.push_back({ shard->base, shard->limit, -1 });
+        shards.push_back(std::move(shard));
+    }
+    physical.assign(static_cast<size_t>(maxMemory), 0);
+}
+
+std::vector<int> MemoryManager::probeOrder(int home) const {
+    int n = static_cast<int>(shards.size());
+    std::vector<int> order;
+    order.reserve(n);
+    order.push_back(home);
+    for (int d = 1; static_cast<int>(order.size()) < n; ++d) {
+        order.push_back((home + d) % n);
+        if (static_cast<int>(order.size()) < n) order.push_back((home - d + n) % n);
+    }
+    return order;
 }
 
 bool MemoryManager::allocate(int pid) {
-    std::lock_guard<std::mutex> lock(mtx);
+    return allocate(pid, memPerProc);
+}
+
+bool MemoryManager::allocate(int pid, int size) {
+    // Whole frames only, so every block starts on a frame boundary
+    size = (size + memPerFrame - 1) / memPerFrame * memPerFrame;
+
+    int home = homeShard(pid);
+    for (int idx : probeOrder(home)) {
+        if (allocateIn(*shards[idx], pid, size)) {
+            if (idx != home) borrows.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Shard bounds never change after construction, so no lock is needed
+bool MemoryManager::fitsInShard(int size) const {
+    if (size < 0) return false;
+    long long rounded = (static_cast<long long>(size) + memPerFrame - 1) / memPerFrame * memPerFrame;
+    for (const auto& shard : shards) {
+        if (rounded <= shard->limit - shard->base) return true;
+    }
+    return false;
+}
+
+bool MemoryManager::allocateIn(MemoryShard& shard, int pid, int size) {
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto& blocks = shard.blocks;
     for (auto it = blocks.begin(); it != blocks.end(); ++it) {
-        if (it->pid == -1 && it->size() >= memPerProc) {
+        if (it->pid == -1 && it->size() >= size) {
             int start = it->start;
-            int end = start + memPerProc;
+            int end = start + size;
 
             MemoryBlock procBlock = { start, end, pid };
 
-            if (it->size() == memPerProc) {
+            if (it->size() == size) {
                 *it = procBlock;
             }
             else {
                 it->start = end;
                 blocks.insert(it, procBlock);
             }
+            std::fill(physical.begin() + start, physical.begin() + end, 0);
+            if (eventLog) eventLog->logAllocate(pid, start, end, globalCpuTicks.load());
             return true;
         }
     }
     return false;
 }
 
+int MemoryManager::largestFreeBlock() {
+    int largest = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mtx);
+        for (const auto& b : shard->blocks) {
+            if (b.pid == -1 && b.size() > largest) largest = b.size();
+        }
+    }
+    return largest;
+}
+
 void MemoryManager::deallocate(int pid) {
-    std::lock_guard<std::mutex> lock(mtx);
-    for (auto& block : blocks) {
-        if (block.pid == pid)
+    for (int idx : probeOrder(homeShard(pid))) {
+        if (deallocateIn(*shards[idx], pid)) break;
+    }
+}
+
+bool MemoryManager::deallocateIn(MemoryShard& shard, int pid) {
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    bool found = false;
+    for (auto& block : shard.blocks) {
+        if (block.pid == pid) {
+            if (eventLog) eventLog->logFree(pid, block.start, block.end, globalCpuTicks.load());
             block.pid = -1;
+            found = true;
+        }
     }
-    mergeFreeBlocks();
+    if (!found) return false;
+    mappingEpoch.fetch_add(1);
+    mergeFreeBlocks(shard.blocks);
+    return true;
 }
 
-void MemoryManager::mergeFreeBlocks() {
+void MemoryManager::mergeFreeBlocks(std::vector<MemoryBlock>& blocks) {
     for (auto it = blocks.begin(); it != blocks.end() - 1;) {
         if (it->pid == -1 && (it + 1)->pid == -1) {
             it->end = (it + 1)->end;
@@ -53,39 +137,286 @@ void MemoryManager::mergeFreeBlocks() {
     }
 }
 
-void MemoryManager::dumpSnapshot(int quantumCycle) {
-    std::lock_guard<std::mutex> lock(mtx);
-    std::ostringstream filename;
-    filename << "memory_stamp_" << std::setw(2) << std::setfill('0') << quantumCycle << ".txt";
-    std::ofstream out(filename.str());
+// Every shard is locked in index order, so concurrent callers cannot deadlock
+std::vector<std::unique_lock<std::mutex>> MemoryManager::lockAllShards() {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(shards.size());
+    for (auto& shard : shards) locks.emplace_back(shard->mtx);
+    return locks;
+}
+
+std::vector<MemoryBlock> MemoryManager::collectBlocks() const {
+    std::vector<MemoryBlock> all;
+    for (const auto& shard : shards)
+        all.insert(all.end(), shard->blocks.begin(), shard->blocks.end());
+    return all;
+}
+
+std::vector<MemoryBlock> MemoryManager::snapshotBlocks() {
+    auto locks = lockAllShards();
+    return collectBlocks();
+}
+
+void MemoryManager::exportLayout(std::vector<MemoryBlock>& allocated, std::vector<char>& contents) {
+    auto locks = lockAllShards();
+    allocated.clear();
+    contents.clear();
+    for (const auto& shard : shards) {
+        for (const auto& b : shard->blocks) {
+            if (b.pid == -1) continue;
+            allocated.push_back(b);
+            contents.insert(contents.end(), physical.begin() + b.start, physical.begin() + b.end);
+        }
+    }
+}
 
-    auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-    std::tm tm;
-#ifdef _WIN32
-    localtime_s(&tm, &now);
-#else
-    localtime_r(&now, &tm);
-#endif
+bool MemoryManager::restoreLayout(const std::vector<MemoryBlock>& allocated, const char* contents, size_t size) {
+    auto locks = lockAllShards();
+    for (const auto& shard : shards) {
+        if (shard->blocks.size() != 1 || shard->blocks[0].pid != -1) return false;
+    }
 
-    out << "Timestamp: (" << std::put_time(&tm, "%m/%d/%Y %I:%M:%S%p") << ")\n";
+    // Lay each shard out as its allocations with free blocks in the gaps
+    std::vector<std::vector<MemoryBlock>> layout(shards.size());
+    std::vector<int> cursor(shards.size());
+    for (size_t i = 0; i < shards.size(); ++i) cursor[i] = shards[i]->base;
+    size_t bytes = 0;
+    for (const auto& b : allocated) {
+        size_t idx = 0;
+        while (idx < shards.size() && b.start >= shards[idx]->limit) idx++;
+        if (idx == shards.size() || b.start < cursor[idx] || b.end <= b.start || b.end > shards[idx]->limit) {
+            return false;
+        }
+        if (b.start > cursor[idx]) layout[idx].push_back({ cursor[idx], b.start, -1 });
+        layout[idx].push_back(b);
+        cursor[idx] = b.end;
+        bytes += static_cast<size_t>(b.size());
+    }
+    if (bytes != size) return false;
 
-    int procCount = 0;
-    for (auto& b : blocks) if (b.pid != -1) procCount++;
-    out << "Number of processes in memory: " << procCount << "\n";
+    for (size_t i = 0; i < shards.size(); ++i) {
+        if (cursor[i] < shards[i]->limit) layout[i].push_back({ cursor[i], shards[i]->limit, -1 });
+        shards[i]->blocks = std::move(layout[i]);
+    }
+    uint64_t tick = globalCpuTicks.load();
+    for (const auto& b : allocated) {
+        std::memcpy(physical.data() + b.start, contents, static_cast<size_t>(b.size()));
+        contents += b.size();
+        if (eventLog) eventLog->logAllocate(b.pid, b.start, b.end, tick);
+    }
+    mappingEpoch.fetch_add(1);
+    return true;
+}
 
+int MemoryManager::externalFragmentationOf(const std::vector<MemoryBlock>& blocks) const {
     int frag = 0;
-    for (auto& b : blocks)
+    for (const auto& b : blocks)
         if (b.pid == -1 && b.size() < memPerProc)
             frag += b.size();
-    out << "Total external fragmentation in KB: " << frag / 1024 << "\n\n";
-
-    out << "----end---- = " << maxMemory << "\n\n";
-    for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
-        if (it->pid != -1) {
-            out << it->end << "\n";
-            out << "P" << it->pid << "\n";
-            out << it->start << "\n\n";
+    return frag;
+}
+
+int MemoryManager::externalFragmentation() {
+    int frag = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mtx);
+        frag += externalFragmentationOf(shard->blocks);
+    }
+    return frag;
+}
+
+int MemoryManager::totalFree() {
+    int free = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mtx);
+        for (const auto& b : shard->blocks)
+            if (b.pid == -1) free += b.size();
+    }
+    return free;
+}
+
+int MemoryManager::largestCompactableBlock() {
+    int largest = 0;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mtx);
+        int free = 0;
+        for (const auto& b : shard->blocks)
+            if (b.pid == -1) free += b.size();
+        if (free > largest) largest = free;
+    }
+    return largest;
+}
+
+// Visits shards round-robin across calls so every shard gets compacted
+int MemoryManager::compactStep(int maxBytes, const std::function<bool(int)>& isPinned) {
+    int moved = 0;
+    for (size_t n = 0; n < shards.size() && moved < maxBytes; ++n) {
+        MemoryShard& shard = *shards[nextCompactShard];
+        nextCompactShard = (nextCompactShard + 1) % shards.size();
+        moved += compactShard(shard, maxBytes - moved, isPinned);
+    }
+
+    std::lock_guard<std::mutex> lock(statsMtx);
+    compaction.steps++;
+    return moved;
+}
+
+int MemoryManager::compactShard(MemoryShard& shard, int maxBytes, const std::function<bool(int)>& isPinned) {
+    std::lock_guard<std::mutex> lock(shard.mtx);
+    auto& blocks = shard.blocks;
+    int before = externalFragmentationOf(blocks);
+    int moved = 0;
+    uint64_t relocations = 0;
+
+    for (size_t i = 0; i + 1 < blocks.size(); ++i) {
+        MemoryBlock& hole = blocks[i];
+        MemoryBlock& next = blocks[i + 1];
+        if (hole.pid != -1 || next.pid == -1) continue;
+        if (isPinned(next.pid) || moved + next.size() > maxBytes) continue;
+
+        // Slide next down to the start of the hole; the hole moves above it
+        int size = next.size();
+        int holeSize = hole.size();
+        if (eventLog) {
+            uint64_t tick = globalCpuTicks.load();
+            eventLog->logFree(next.pid, next.start, next.end, tick);
+            eventLog->logAllocate(next.pid, hole.start, hole.start + size, tick);
+        }
+        std::memmove(physical.data() + hole.start, physical.data() + next.start, static_cast<size_t>(size));
+        MemoryBlock relocated = { hole.start, hole.start + size, next.pid };
+        MemoryBlock freed = { hole.start + size, hole.start + size + holeSize, -1 };
+        hole = relocated;
+        next = freed;
+        moved += size;
+        relocations++;
+
+        // Merge the moved hole with a free block above it
+        if (i + 2 < blocks.size() && blocks[i + 2].pid == -1) {
+            blocks[i + 1].end = blocks[i + 2].end;
+            blocks.erase(blocks.begin() + (i + 2));
         }
     }
-    out << "----start---- = 0\n";
+    if (moved == 0) return 0;
+
+    mappingEpoch.fetch_add(1);
+    int after = externalFragmentationOf(blocks);
+
+    std::lock_guard<std::mutex> statsLock(statsMtx);
+    compaction.relocations += relocations;
+    compaction.bytesMoved += moved;
+    if (before > after) compaction.fragmentationRecovered += before - after;
+    return moved;
+}
+
+CompactionStats MemoryManager::getCompactionStats() {
+    std::lock_guard<std::mutex> lock(statsMtx);
+    return compaction;
+}
+
+// Called once before the scheduler starts
+void MemoryManager::configureTlbs(int numCores, size_t entriesPerCore) {
+    tlbs.clear();
+    for (int i = 0; i < numCores; ++i)
+        tlbs.emplace_back(std::make_unique<SoftTlb>(entriesPerCore));
+}
+
+// The home shard is checked first; borrowed blocks cost a longer walk
+bool MemoryManager::walkPageTable(int pid, uint32_t vpn, uint32_t& frame) {
+    pageWalks.fetch_add(1, std::memory_order_relaxed);
+    for (int idx : probeOrder(homeShard(pid))) {
+        MemoryShard& shard = *shards[idx];
+        std::lock_guard<std::mutex> lock(shard.mtx);
+        for (const auto& b : shard.blocks) {
+            if (b.pid != pid) continue;
+            uint32_t pages = static_cast<uint32_t>(b.size() / memPerFrame);
+            if (vpn >= pages) return false;
+            frame = static_cast<uint32_t>(b.start / memPerFrame) + vpn;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool MemoryManager::translate(int pid, int coreId, uint32_t address, uint32_t& physicalAddress) {
+    uint32_t vpn = address / static_cast<uint32_t>(memPerFrame);
+    uint32_t offset = address % static_cast<uint32_t>(memPerFrame);
+    uint32_t frame = 0;
+
+    SoftTlb* tlb = (coreId >= 0 && coreId < static_cast<int>(tlbs.size())) ? tlbs[coreId].get() : nullptr;
+    if (tlb && tlb->lookup(pid, vpn, mappingEpoch.load(), frame)) {
+        physicalAddress = frame * static_cast<uint32_t>(memPerFrame) + offset;
+        return true;
+    }
+    if (!walkPageTable(pid, vpn, frame)) return false;
+    if (tlb) tlb->insert(pid, vpn, frame);
+    physicalAddress = frame * static_cast<uint32_t>(memPerFrame) + offset;
+    return true;
+}
+
+// Values are stored little-endian; each byte is translated on its own so a
+// value may straddle a page boundary
+bool MemoryManager::read16(int pid, int coreId, uint32_t address, uint16_t& value) {
+    uint32_t lo = 0, hi = 0;
+    if (!translate(pid, coreId, address, lo)) return false;
+    if ((address + 1) % static_cast<uint32_t>(memPerFrame) == 0) {
+        if (!translate(pid, coreId, address + 1, hi)) return false;
+    }
+    else {
+        hi = lo + 1;
+    }
+    value = static_cast<uint16_t>(physical[lo] | (physical[hi] << 8));
+    return true;
+}
+
+bool MemoryManager::write16(int pid, int coreId, uint32_t address, uint16_t value) {
+    uint32_t lo = 0, hi = 0;
+    if (!translate(pid, coreId, address, lo)) return false;
+    if ((address + 1) % static_cast<uint32_t>(memPerFrame) == 0) {
+        if (!translate(pid, coreId, address + 1, hi)) return false;
+    }
+    else {
+        hi = lo + 1;
+    }
+    physical[lo] = static_cast<uint8_t>(value & 0xFF);
+    physical[hi] = static_cast<uint8_t>(value >> 8);
+    return true;
+}
+
+uint64_t MemoryManager::getTlbHits() const {
+    uint64_t total = 0;
+    for (const auto& t : tlbs) total += t->getHits();
+    return total;
+}
+
+uint64_t MemoryManager::getTlbMisses() const {
+    uint64_t total = 0;
+    for (const auto& t : tlbs) total += t->getMisses();
+    return total;
+}
+
+// Called once before the scheduler starts
+bool MemoryManager::enableEventLog(const std::string& path, uint32_t checkpointInterval) {
+    eventLog = std::make_unique<MemoryEventLog>(path, maxMemory, memPerProc, memPerFrame,
+        static_cast<int>(shards.size()), checkpointInterval);
+    if (!eventLog->isOpen()) {
+        eventLog.reset();
+        return false;
+    }
+    return true;
+}
+
+void MemoryManager::dumpSnapshot(int quantumCycle) {
+    std::vector<MemoryBlock> blocks;
+    {
+        // Logged under the shard locks so the checkpoint matches the event stream
+        auto locks = lockAllShards();
+        blocks = collectBlocks();
+        if (eventLog) eventLog->logQuantum(quantumCycle, globalCpuTicks.load(), blocks);
+    }
+    if (!textSnapshots) return;
+
+    std::ostringstream filename;
+    filename << "memory_stamp_" << std::setw(2) << std::setfill('0') << quantumCycle << ".txt";
+    std::ofstream out(filename.str());
+    renderMemoryStamp(out, blocks, maxMemory, memPerProc, time(nullptr));
 }
@@ -1,6 +1,14 @@
 #pragma once
 #include <vector>
 #include <mutex>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <atomic>
+
+#include "MemoryEventLog.h"
+#include "SoftTlb.h"
 
 // Represents a block in memory
 struct MemoryBlock {
@@ -11,27 +19,126 @@ struct MemoryBlock {
     int size() const { return end - start; }
 };
 
-// Thread-safe memory manager
+// Running totals of the compaction engine
+struct CompactionStats {
+    uint64_t steps = 0;
+    uint64_t relocations = 0;
+    uint64_t bytesMoved = 0;
+    uint64_t fragmentationRecovered = 0;  // bytes of external fragmentation removed
+};
+
+// One contiguous region of memory with its own free list and lock
+struct MemoryShard {
+    std::mutex mtx;
+    std::vector<MemoryBlock> blocks;  // covers [base, limit)
+    int base = 0;
+    int limit = 0;
+};
+
+// Thread-safe memory manager. Memory is split into shards; a process is
+// placed in its home shard (pid % shards) and borrows from the nearest
+// neighbouring shard when the home shard is full. Each call locks one shard
+// at a time, except the whole-memory snapshot, which locks all of them.
 class MemoryManager {
 public:
     // Constructor with configuration parameters
-    MemoryManager(int maxMemory, int memPerProc, int memPerFrame);
+    MemoryManager(int maxMemory, int memPerProc, int memPerFrame, int numShards = 1);
 
     // Tries to allocate memory for the process. Returns true if successful.
     bool allocate(int pid);
+    bool allocate(int pid, int size);
+
+    // Size of the largest free block; any request up to this size will fit
+    int largestFreeBlock();
+    int getMemPerProc() const { return memPerProc; }
+    int getShardCount() const { return static_cast<int>(shards.size()); }
+    // Largest request that can ever be placed: one allocation never spans
+    // shards, and the frame-rounded size must fit in the biggest of them
+    bool fitsInShard(int size) const;
+
+    // Whole-memory block list in address order
+    std::vector<MemoryBlock> snapshotBlocks();
+
+    // Allocations placed outside the home shard
+    uint64_t getBorrowCount() const { return borrows.load(std::memory_order_relaxed); }
 
     // Frees memory used by the given process
     void deallocate(int pid);
 
-    // Dumps a snapshot of memory state into memory_stamp_<cycle>.txt
+    // Records a quantum boundary in the event log, and writes
+    // memory_stamp_<cycle>.txt when text snapshots are enabled
     void dumpSnapshot(int quantumCycle);
 
+    // Starts the binary event log; a checkpoint is written every checkpointInterval quanta
+    bool enableEventLog(const std::string& path, uint32_t checkpointInterval);
+    void setTextSnapshots(bool enabled) { textSnapshots = enabled; }
+
+    // One bounded compaction step: slides movable allocations down into the
+    // holes below them, moving at most maxBytes. Processes for which isPinned
+    // returns true are never moved. Returns the bytes moved.
+    int compactStep(int maxBytes, const std::function<bool(int)>& isPinned);
+    CompactionStats getCompactionStats();
+    // Largest block compaction could ever make: blocks only slide within
+    // their shard, so this is the most free memory in any one shard
+    int largestCompactableBlock();
+
+    // Free bytes in holes too small for a default-sized process
+    int externalFragmentation();
+    int totalFree();
+
+    // Emulated memory for the READ/WRITE opcodes. Addresses are offsets into
+    // the process's own block, translated per mem-per-frame page through the
+    // calling core's TLB. Return false on an access outside the block.
+    void configureTlbs(int numCores, size_t entriesPerCore);
+    bool read16(int pid, int coreId, uint32_t address, uint16_t& value);
+    bool write16(int pid, int coreId, uint32_t address, uint16_t value);
+
+    uint64_t getTlbHits() const;
+    uint64_t getTlbMisses() const;
+    uint64_t getPageWalks() const { return pageWalks.load(std::memory_order_relaxed); }
+
+    int getMaxMemory() const { return maxMemory; }
+    int getMemPerFrame() const { return memPerFrame; }
+
+    // Checkpoint support. exportLayout returns the allocated blocks in
+    // address order and their bytes back to back. restoreLayout puts them
+    // back into an empty memory of the same size; it fails, changing
+    // nothing, if something is allocated or a block does not fit in one shard.
+    void exportLayout(std::vector<MemoryBlock>& allocated, std::vector<char>& contents);
+    bool restoreLayout(const std::vector<MemoryBlock>& allocated, const char* contents, size_t size);
+
 private:
+    int homeShard(int pid) const { return pid % static_cast<int>(shards.size()); }
+    // Shard indices starting at home, then alternating outwards
+    std::vector<int> probeOrder(int home) const;
+
+    bool allocateIn(MemoryShard& shard, int pid, int size);
+    bool deallocateIn(MemoryShard& shard, int pid);
+    int compactShard(MemoryShard& shard, int maxBytes, const std::function<bool(int)>& isPinned);
+
+    std::vector<std::unique_lock<std::mutex>> lockAllShards();
+    std::vector<MemoryBlock> collectBlocks() const;  // caller holds every shard lock
+
     // Merges adjacent free blocks
-    void mergeFreeBlocks();
+    void mergeFreeBlocks(std::vector<MemoryBlock>& blocks);
+    int externalFragmentationOf(const std::vector<MemoryBlock>& blocks) const;
 
-    std::vector<MemoryBlock> blocks;
-    std::mutex mtx;
+    bool translate(int pid, int coreId, uint32_t address, uint32_t& physicalAddress);
+    bool walkPageTable(int pid, uint32_t vpn, uint32_t& frame);
+
+    std::vector<std::unique_ptr<MemoryShard>> shards;
+    std::unique_ptr<MemoryEventLog> eventLog;        // internally locked
+    bool textSnapshots = false;
+    std::atomic<uint64_t> borrows{ 0 };
+    size_t nextCompactShard = 0;                     // scheduler thread only
+
+    std::mutex statsMtx;
+    CompactionStats compaction;
+
+    std::vector<uint8_t> physical;                   // backing store, maxMemory bytes
+    std::vector<std::unique_ptr<SoftTlb>> tlbs;      // one per core
+    std::atomic<uint64_t> mappingEpoch{ 0 };         // bumped when a block is freed or moved
+    std::atomic<uint64_t> pageWalks{ 0 };
 
     const int maxMemory;
     const int memPerProc;
@@ -0,0 +1,149 @@
+#include "MetricsExporter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char* const UnixPrefix = "unix:";
+}
+
+MetricsExporter::MetricsExporter(Render render) : render_(std::move(render)) {
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop();
+}
+
+bool MetricsExporter::start(const std::string& target, uint64_t intervalMs) {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    if (running_.load()) return false;
+    target_ = target;
+    intervalMs_ = intervalMs < 1 ? 1 : intervalMs;
+    socket_ = target.compare(0, std::strlen(UnixPrefix), UnixPrefix) == 0;
+    path_ = socket_ ? target.substr(std::strlen(UnixPrefix)) : target;
+    if (path_.empty()) return false;
+
+    if (socket_) {
+#ifdef _WIN32
+        return false;
+#else
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path_.size() >= sizeof(addr.sun_path)) return false;
+        std::memcpy(addr.sun_path, path_.c_str(), path_.size() + 1);
+        listenFd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd_ < 0) return false;
+        unlink(path_.c_str());   // left behind by an earlier run
+        if (bind(listenFd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd_, 8) != 0) {
+            close(listenFd_);
+            listenFd_ = -1;
+            return false;
+        }
+        running_ = true;
+        thread_ = std::thread(&MetricsExporter::socketLoop, this);
+#endif
+    }
+    else {
+        // Fail now rather than on every interval
+        if (!writeFile(render_())) return false;
+        exports_++;
+        running_ = true;
+        thread_ = std::thread(&MetricsExporter::fileLoop, this);
+    }
+    return true;
+}
+
+void MetricsExporter::stop() {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    if (!running_.load()) return;
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+#ifndef _WIN32
+    if (listenFd_ >= 0) {
+        close(listenFd_);
+        listenFd_ = -1;
+        unlink(path_.c_str());
+    }
+#endif
+}
+
+// Writes next to the target and renames over it; rename replaces the old
+// page in one step, so readers see either the old or the new one
+bool MetricsExporter::writeFile(const std::string& text) {
+    std::string temp = path_ + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out << text;
+        if (!out.flush()) return false;
+    }
+#ifdef _WIN32
+    return MoveFileExA(temp.c_str(), path_.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(temp.c_str(), path_.c_str()) == 0;
+#endif
+}
+
+void MetricsExporter::fileLoop() {
+    auto next = std::chrono::steady_clock::now() + std::chrono::milliseconds(intervalMs_);
+    while (running_.load()) {
+        if (std::chrono::steady_clock::now() < next) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        next += std::chrono::milliseconds(intervalMs_);
+        if (writeFile(render_())) exports_++;
+    }
+}
+
+// Renders on the interval, not per client, so scraping never adds load to
+// the emulator; a client gets the latest page and the connection is closed
+void MetricsExporter::socketLoop() {
+#ifndef _WIN32
+    std::string page = render_();
+    exports_++;
+    auto next = std::chrono::steady_clock::now() + std::chrono::milliseconds(intervalMs_);
+    while (running_.load()) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next) {
+            next += std::chrono::milliseconds(intervalMs_);
+            page = render_();
+            exports_++;
+            continue;
+        }
+
+        pollfd pfd{ listenFd_, POLLIN, 0 };
+        if (poll(&pfd, 1, 10) <= 0 || !(pfd.revents & POLLIN)) continue;
+        int client = accept(listenFd_, nullptr, nullptr);
+        if (client < 0) continue;
+
+        timeval timeout{ 1, 0 };   // a stalled client must not stall the exporter
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        size_t sent = 0;
+        while (sent < page.size()) {
+            ssize_t n = send(client, page.data() + sent, page.size() - sent, flags);
+            if (n <= 0) break;
+            sent += static_cast<size_t>(n);
+        }
+        close(client);
+        scrapes_++;
+    }
+#endif
+}
@@ -0,0 +1,49 @@
+// MetricsExporter.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Background exposition of metrics in the Prometheus text format. Every
+// interval the render callback is called once on the exporter thread, and
+// the text is either written to a file (through a temporary file and a
+// rename, so a scraper never reads half a page) or kept for a local Unix
+// domain socket that hands the latest page to each client that connects.
+class MetricsExporter {
+public:
+    using Render = std::function<std::string()>;
+
+    explicit MetricsExporter(Render render);
+    ~MetricsExporter();
+
+    // target is a file path, or "unix:<path>" for a socket (not on Windows).
+    // Returns false if it cannot be opened or the exporter already runs.
+    bool start(const std::string& target, uint64_t intervalMs);
+    void stop();
+
+    bool isRunning() const { return running_.load(); }
+    const std::string& getTarget() const { return target_; }
+    uint64_t getExports() const { return exports_.load(); }   // pages rendered
+    uint64_t getScrapes() const { return scrapes_.load(); }   // socket clients served
+
+private:
+    void fileLoop();
+    void socketLoop();
+    bool writeFile(const std::string& text);
+
+    Render render_;
+    std::string target_;
+    std::string path_;
+    uint64_t intervalMs_ = 1000;
+    bool socket_ = false;
+    int listenFd_ = -1;
+
+    std::mutex controlMutex_;   // start/stop
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    std::atomic<uint64_t> exports_{ 0 };
+    std::atomic<uint64_t> scrapes_{ 0 };
+};
@@ -0,0 +1,103 @@
+#include "MlfqQueue.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+int lowestSetBit(uint64_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+}
+
+MlfqQueue::MlfqQueue(const std::vector<uint64_t>& quantums)
+    : quantums_(quantums) {
+    if (quantums_.empty()) quantums_.push_back(1);
+    if (quantums_.size() > MaxLevels) quantums_.resize(MaxLevels);
+    queues_.resize(quantums_.size());
+    stats_.resize(quantums_.size());
+    for (size_t i = 0; i < quantums_.size(); ++i) stats_[i].quantum = quantums_[i];
+}
+
+uint64_t MlfqQueue::quantumFor(const Process& p) const {
+    int level = p.getSchedLevel();
+    if (level < 0 || level >= levels()) level = levels() - 1;
+    return quantums_[level];
+}
+
+void MlfqQueue::pushLocked(std::shared_ptr<Process> p, uint64_t now) {
+    if (p->getBoostEpoch() != boostEpoch_) {
+        p->setSchedLevel(0);
+        p->setBoostEpoch(boostEpoch_);
+    }
+    int level = p->getSchedLevel();
+    if (level >= levels()) level = levels() - 1;
+    p->setReadyTick(now);
+    queues_[level].push_back(std::move(p));
+    nonEmpty_ |= (1ULL << level);
+    size_++;
+}
+
+void MlfqQueue::push(std::shared_ptr<Process> p, uint64_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pushLocked(std::move(p), now);
+}
+
+void MlfqQueue::pushDemoted(std::shared_ptr<Process> p, uint64_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // A boost since the process was dispatched overrides the demotion
+    if (p->getBoostEpoch() == boostEpoch_ && p->getSchedLevel() < levels() - 1)
+        p->setSchedLevel(p->getSchedLevel() + 1);
+    pushLocked(std::move(p), now);
+}
+
+bool MlfqQueue::try_pop(std::shared_ptr<Process>& p, uint64_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (nonEmpty_ == 0) return false;
+
+    int level = lowestSetBit(nonEmpty_);
+    auto& queue = queues_[level];
+    p = queue.front();
+    queue.pop_front();
+    if (queue.empty()) nonEmpty_ &= ~(1ULL << level);
+    size_--;
+
+    uint64_t wait = now >= p->getReadyTick() ? now - p->getReadyTick() : 0;
+    MlfqLevelStats& st = stats_[level];
+    st.dispatches++;
+    st.totalWait += wait;
+    if (wait > st.maxWait) st.maxWait = wait;
+    return true;
+}
+
+void MlfqQueue::boost() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    boostEpoch_++;
+    // Keep the relative order: higher levels are appended after level 0
+    for (int level = 1; level < levels(); ++level) {
+        for (auto& p : queues_[level]) queues_[0].push_back(std::move(p));
+        queues_[level].clear();
+    }
+    for (auto& p : queues_[0]) {
+        p->setSchedLevel(0);
+        p->setBoostEpoch(boostEpoch_);
+    }
+    nonEmpty_ = queues_[0].empty() ? 0 : 1ULL;
+}
+
+size_t MlfqQueue::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+std::vector<MlfqLevelStats> MlfqQueue::getStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<MlfqLevelStats> out = stats_;
+    for (size_t i = 0; i < out.size(); ++i) out[i].queued = queues_[i].size();
+    return out;
+}
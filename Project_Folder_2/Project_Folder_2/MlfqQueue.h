@@ -0,0 +1,52 @@
+// MlfqQueue.h
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Process.h"
+
+// Dispatch wait per MLFQ level, in CPU ticks
+struct MlfqLevelStats {
+    uint64_t quantum = 0;
+    uint64_t dispatches = 0;
+    uint64_t totalWait = 0;
+    uint64_t maxWait = 0;
+    size_t   queued = 0;
+};
+
+// Thread-safe multilevel feedback queue. Level 0 has the highest priority.
+// A bitmask of non-empty levels gives O(1) selection of the next process.
+// A process that uses its whole quantum is demoted one level; boost() moves
+// everything back to level 0 so long-running processes cannot starve.
+class MlfqQueue {
+public:
+    static const int MaxLevels = 64;
+
+    explicit MlfqQueue(const std::vector<uint64_t>& quantums);
+
+    int levels() const { return static_cast<int>(quantums_.size()); }
+    uint64_t quantumFor(const Process& p) const;
+
+    // Queues p at its current level (level 0 if a boost happened since it last ran)
+    void push(std::shared_ptr<Process> p, uint64_t now);
+    void pushDemoted(std::shared_ptr<Process> p, uint64_t now);
+    bool try_pop(std::shared_ptr<Process>& p, uint64_t now);
+
+    void boost();
+    size_t size();
+    std::vector<MlfqLevelStats> getStats();
+
+private:
+    void pushLocked(std::shared_ptr<Process> p, uint64_t now);
+
+    std::mutex mutex_;
+    std::vector<uint64_t> quantums_;
+    std::vector<std::deque<std::shared_ptr<Process>>> queues_;
+    std::vector<MlfqLevelStats> stats_;
+    uint64_t nonEmpty_ = 0;    // bit i set when level i has processes
+    uint64_t boostEpoch_ = 0;
+    size_t size_ = 0;
+};
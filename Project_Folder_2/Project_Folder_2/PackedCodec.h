@@ -0,0 +1,193 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Bytecode.h"
+#include "Process.h"
+
+// Byte-level encoding shared by the workload and checkpoint files. Integers
+// are LEB128 varints (signed ones zigzag-encoded first); strings are a
+// length and bytes. A program is an instruction count followed by, per
+// instruction, one byte (opcode in the low nibble, argument count in the
+// high one) and its arguments. Each argument refers to a string table that
+// spans the whole stream: 0 defines the next entry inline, n > 0 reuses
+// entry n - 1. Writer and reader must see the programs in the same order.
+// Bytecode (see Bytecode.h) is not encoded; files store it as is.
+class PackedWriter {
+public:
+    static const size_t MaxArgs = 15;   // fits the high nibble
+
+    std::vector<char>& buffer() { return buf_; }
+    void clear() { buf_.clear(); }          // the string table is kept
+    void resetStrings() { strings_.clear(); }
+
+    void putVarint(uint64_t value) {
+        while (value >= 0x80) {
+            buf_.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        buf_.push_back(static_cast<char>(value));
+    }
+    void putSigned(int64_t value) {
+        putVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+    void putString(const std::string& s) {
+        putVarint(s.size());
+        buf_.insert(buf_.end(), s.begin(), s.end());
+    }
+    void putBytes(const void* data, size_t size) {
+        const char* p = static_cast<const char*>(data);
+        buf_.insert(buf_.end(), p, p + size);
+    }
+
+    void putProgram(const std::vector<Process::Instruction>& program) {
+        putVarint(program.size());
+        for (const auto& ins : program) {
+            size_t argc = ins.args.size() < MaxArgs ? ins.args.size() : MaxArgs;
+            buf_.push_back(static_cast<char>((ins.opcode & 0x0F) | (argc << 4)));
+            for (size_t a = 0; a < argc; ++a) {
+                auto it = strings_.find(ins.args[a]);
+                if (it != strings_.end()) {
+                    putVarint(it->second + 1);
+                }
+                else {
+                    putVarint(0);
+                    putString(ins.args[a]);
+                    strings_.emplace(ins.args[a], strings_.size());
+                }
+            }
+        }
+    }
+
+    static size_t storedOperands(const PackedInstruction& ins) {
+        return ins.argc < PackedOperands ? ins.argc : PackedOperands;
+    }
+
+private:
+    std::vector<char> buf_;
+    std::unordered_map<std::string, uint64_t> strings_;
+};
+
+// Checks bytecode mapped from a file before a process runs it in place:
+// every opcode and argument count must fit the head byte putProgram writes
+// when the process is recorded, and every name operand must be below names.
+// A restore checks every instruction of every process, so the roles are
+// looked up in a table rather than branched on.
+inline bool bytecodeFits(const PackedInstruction* code, size_t count, size_t names) {
+    struct Roles { uint8_t name[16]; uint8_t value[16]; };     // bit a: operand a
+    static const Roles roles = [] {
+        Roles r{};
+        for (uint8_t op = 0; op < 16; ++op) {
+            for (size_t a = 0; a < PackedOperands; ++a) {
+                if (operandRole(op, a) == OperandRole::Name) r.name[op] |= 1 << a;
+                if (operandRole(op, a) == OperandRole::Value) r.value[op] |= 1 << a;
+            }
+        }
+        return r;
+    }();
+    for (size_t i = 0; i < count; ++i) {
+        const PackedInstruction& ins = code[i];
+        if (ins.opcode > 0x0F || ins.argc > PackedWriter::MaxArgs) return false;
+        unsigned stored = (1u << PackedWriter::storedOperands(ins)) - 1;
+        unsigned bad = 0;
+        for (unsigned a = 0; a < PackedOperands; ++a) {
+            uint32_t operand = ins.args[a];
+            unsigned named = (roles.name[ins.opcode] >> a) | ((roles.value[ins.opcode] >> a) & (operand >> 31));
+            bad |= named & (stored >> a) & ((operand & ~OperandVariable) >= names);
+        }
+        if (bad & 1) return false;
+    }
+    return true;
+}
+
+// Reads what PackedWriter wrote from a byte range it does not own. Every
+// get returns false, and leaves the reader at the end, on truncated or
+// inconsistent input.
+class PackedReader {
+public:
+    PackedReader() = default;
+    PackedReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    size_t position() const { return pos_; }
+    bool atEnd() const { return pos_ >= size_; }
+    void resetStrings() { strings_.clear(); }
+
+    bool getVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && pos_ < size_; shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(data_[pos_++]);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return fail();
+    }
+    bool getSigned(int64_t& value) {
+        uint64_t raw;
+        if (!getVarint(raw)) return false;
+        value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+        return true;
+    }
+    bool getString(std::string& s) {
+        uint64_t length;
+        if (!getVarint(length) || length > size_ - pos_) return fail();
+        s.assign(data_ + pos_, static_cast<size_t>(length));
+        pos_ += static_cast<size_t>(length);
+        return true;
+    }
+    bool getBytes(void* out, size_t size) {
+        if (size > size_ - pos_) return fail();
+        std::memcpy(out, data_ + pos_, size);
+        pos_ += size;
+        return true;
+    }
+    // Like getBytes, but points into the underlying range instead of copying
+    bool getView(const char*& at, size_t size) {
+        if (size > size_ - pos_) return fail();
+        at = data_ + pos_;
+        pos_ += size;
+        return true;
+    }
+
+    bool getProgram(std::vector<Process::Instruction>& program) {
+        uint64_t count;
+        // Every instruction takes at least a byte
+        if (!getVarint(count) || count > size_ - pos_) return fail();
+        program.assign(static_cast<size_t>(count), Process::Instruction());
+        for (auto& ins : program) {
+            if (pos_ >= size_) return fail();
+            uint8_t head = static_cast<uint8_t>(data_[pos_++]);
+            ins.opcode = head & 0x0F;
+            ins.args.resize(head >> 4);
+            for (auto& arg : ins.args) {
+                uint64_t ref;
+                if (!getVarint(ref)) return false;
+                if (ref == 0) {
+                    if (!getString(arg)) return false;
+                    strings_.push_back(arg);
+                }
+                else if (ref - 1 < strings_.size()) {
+                    arg = strings_[static_cast<size_t>(ref - 1)];
+                }
+                else {
+                    return fail();
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    bool fail() {
+        pos_ = size_;
+        return false;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t pos_ = 0;
+    std::vector<std::string> strings_;
+};
@@ -4,6 +4,7 @@
 #include <chrono>
 #include <climits>
 #include <cstdint>
+#include <cstdlib>
 #include <unordered_map>
 #include <utility>
 #include <string>
@@ -16,6 +17,8 @@
 
 #include "Process.h"
 #include "GlobalState.h"
+#include "MemoryManager.h"
+#include "PackedCodec.h"
 
 static std::random_device rd;
 static std::mt19937 gen(rd());
@@ -23,6 +26,58 @@ static std::mt19937 gen(rd());
 Process::Process(int pid, std::string name)
     : pid_(pid), name_(std::move(name)), finished_(false), isSleeping_(false), sleepTargetTick_(0), inMemory_(false) {}
 
+namespace {
+uint64_t steadyNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t since(uint64_t from, uint64_t to) {
+    return to > from ? to - from : 0;
+}
+}
+
+void Process::markArrival(uint64_t tick) {
+    arrivalTick_ = tick;
+    arrivalNanos_ = steadyNanos();
+    readySince_ = { tick, arrivalNanos_ };
+}
+
+void Process::markReady(uint64_t tick) {
+    readySince_ = { tick, steadyNanos() };
+}
+
+void Process::markDispatched(uint64_t tick) {
+    uint64_t nanos = steadyNanos();
+    waitTotal_.ticks += since(readySince_.ticks, tick);
+    waitTotal_.nanos += since(readySince_.nanos, nanos);
+    runningSince_ = { tick, nanos };
+    if (!dispatched_) {
+        dispatched_ = true;
+        firstDispatch_ = { tick, nanos };
+    }
+}
+
+void Process::markDescheduled(uint64_t tick) {
+    runTotal_.ticks += since(runningSince_.ticks, tick);
+    runTotal_.nanos += since(runningSince_.nanos, steadyNanos());
+    snapshotRemainingWork();
+}
+
+void Process::markFinished(uint64_t tick) {
+    finishTick_ = tick;
+    finishNanos_ = steadyNanos();
+}
+
+Process::Timing Process::getResponseTime() const {
+    if (!dispatched_) return {};
+    return { since(arrivalTick_, firstDispatch_.ticks), since(arrivalNanos_, firstDispatch_.nanos) };
+}
+
+Process::Timing Process::getTurnaroundTime() const {
+    return { since(arrivalTick_, finishTick_), since(arrivalNanos_, finishNanos_) };
+}
+
 void Process::setInMemory(bool value) {
     inMemory_ = value;
 }
@@ -31,19 +86,12 @@ bool Process::isInMemory() const {
     return inMemory_;
 }
 
-void Process::execute(const Instruction& ins, int coreId) {
-    auto getValue = [this](const std::string& token) -> uint16_t {
-        if (isdigit(token[0]) || (token[0] == '-' && token.size() > 1)) {
-            try {
-                return static_cast<uint16_t>(std::stoi(token));
-            }
-            catch (const std::out_of_range&) {
-                return 0;
-            }
-        }
-        else {
-            return vars.count(token) ? vars[token] : 0;
-        }
+void Process::execute(const PackedInstruction& ins, int coreId) {
+    const std::vector<std::string>& names = image_->names;
+    auto getValue = [&](uint32_t operand) -> uint16_t {
+        if (!(operand & OperandVariable)) return static_cast<uint16_t>(operand);
+        auto it = vars.find(names[operand & ~OperandVariable]);
+        return it != vars.end() ? it->second : 0;
         };
 
     auto clamp = [](int64_t val) -> uint16_t {
@@ -52,22 +100,27 @@ void Process::execute(const Instruction& ins, int coreId) {
         return static_cast<uint16_t>(val);
         };
 
-    if (ins.opcode == 1 && ins.args.size() >= 1) {
-        const std::string& var = ins.args[0];
-        uint16_t value = ins.args.size() == 2 ? clamp(getValue(ins.args[1])) : 0;
-        vars[var] = value;
+    auto accessViolation = [this](uint32_t address) {
+        std::stringstream ss;
+        ss << "[Error] Memory access violation at 0x" << std::hex << std::uppercase << address
+            << ". Process terminated.";
+        logs_.emplace_back(time(nullptr), ss.str());
+        finished_ = true;
+        };
+
+    if (ins.opcode == 1 && ins.argc >= 1) {
+        uint16_t value = ins.argc == 2 ? clamp(getValue(ins.args[1])) : 0;
+        vars[names[ins.args[0]]] = value;
     }
-    else if (ins.opcode == 2 && ins.args.size() == 3) {
-        const std::string& dest = ins.args[0];
+    else if (ins.opcode == 2 && ins.argc == 3) {
         uint16_t a = getValue(ins.args[1]);
         uint16_t b = getValue(ins.args[2]);
-        vars[dest] = clamp(static_cast<int64_t>(a) + static_cast<int64_t>(b));
+        vars[names[ins.args[0]]] = clamp(static_cast<int64_t>(a) + static_cast<int64_t>(b));
     }
-    else if (ins.opcode == 3 && ins.args.size() == 3) {
-        const std::string& dest = ins.args[0];
+    else if (ins.opcode == 3 && ins.argc == 3) {
         uint16_t a = getValue(ins.args[1]);
         uint16_t b = getValue(ins.args[2]);
-        vars[dest] = clamp(static_cast<int64_t>(a) - static_cast<int64_t>(b));
+        vars[names[ins.args[0]]] = clamp(static_cast<int64_t>(a) - static_cast<int64_t>(b));
     }
     else if (ins.opcode == 4) {
         std::string output = "Hello world from " + name_ + "!";
@@ -81,13 +134,13 @@ void Process::execute(const Instruction& ins, int coreId) {
         logs_.emplace_back(time(nullptr), ss.str());
     }
 
-    else if (ins.opcode == 5 && ins.args.size() == 1) {
+    else if (ins.opcode == 5 && ins.argc == 1) {
         uint8_t ticks = static_cast<uint8_t>(getValue(ins.args[0]));
         isSleeping_ = true;
         sleepTargetTick_ = globalCpuTicks.load() + ticks;
         insCount_++;
     }
-    else if (ins.opcode == 6 && ins.args.size() == 1) { // FOR(repeats)
+    else if (ins.opcode == 6 && ins.argc == 1) { // FOR(repeats)
         uint16_t repeatCount = getValue(ins.args[0]);
 
         // Clamp to prevent extremely large repeats
@@ -104,10 +157,32 @@ void Process::execute(const Instruction& ins, int coreId) {
         loopStack.push_back(loop);
     }
 
+    else if (ins.opcode == 8 && ins.argc == 2) { // READ var, address
+        uint32_t address = ins.args[1];
+        uint16_t value = 0;
+        if (memory_ && !memory_->read16(pid_, coreId, address, value)) {
+            accessViolation(address);
+            return;
+        }
+        vars[names[ins.args[0]]] = value;
+    }
+
+    else if (ins.opcode == 9 && ins.argc == 2) { // WRITE address, value
+        uint32_t address = ins.args[0];
+        uint16_t value = getValue(ins.args[1]);
+        if (memory_ && !memory_->write16(pid_, coreId, address, value)) {
+            accessViolation(address);
+            return;
+        }
+    }
+
     else if (ins.opcode == 7) { // END
         if (!loopStack.empty()) {
             LoopState& currentLoop = loopStack.back();
             currentLoop.repeats--;
+            ensureCostIndex();
+            int slot = loopSlot(currentLoop.startIns - 1);
+            if (slot >= 0) loopPasses_[slot].fetch_add(1, std::memory_order_relaxed);
 
             if (currentLoop.repeats > 0) {
                 insCount_ = currentLoop.startIns - 1; // Jump back
@@ -122,13 +197,92 @@ void Process::execute(const Instruction& ins, int coreId) {
     }
 }
 
-void Process::genRandInst(uint64_t min_ins, uint64_t max_ins) {
-    insList.clear();
+void Process::compile(const std::vector<Instruction>& program, std::vector<PackedInstruction>& code,
+    NameTable& names) {
+    auto value = [&](const std::string& token) -> uint32_t {
+        if (isdigit(static_cast<unsigned char>(token[0])) || (token[0] == '-' && token.size() > 1)) {
+            try {
+                return static_cast<uint16_t>(std::stoi(token));
+            }
+            catch (const std::exception&) {
+                return 0;
+            }
+        }
+        return names.intern(token) | OperandVariable;
+        };
+    // Addresses are written in hex ("0x1F4"); plain decimal is accepted too
+    auto address = [](const std::string& token) -> uint32_t {
+        try {
+            return static_cast<uint32_t>(std::stoul(token, nullptr, 0));
+        }
+        catch (const std::exception&) {
+            return UINT32_MAX;
+        }
+        };
+
+    code.reserve(code.size() + program.size());
+    for (const auto& ins : program) {
+        PackedInstruction packed = {};
+        packed.opcode = ins.opcode;
+        packed.argc = static_cast<uint8_t>(std::min<size_t>(ins.args.size(), PackedWriter::MaxArgs));
+        for (size_t a = 0; a < PackedWriter::storedOperands(packed); ++a) {
+            switch (operandRole(ins.opcode, a)) {
+            case OperandRole::Name: packed.args[a] = names.intern(ins.args[a]); break;
+            case OperandRole::Value: packed.args[a] = value(ins.args[a]); break;
+            case OperandRole::Address: packed.args[a] = address(ins.args[a]); break;
+            }
+        }
+        code.push_back(packed);
+    }
+}
+
+std::vector<Process::Instruction> Process::getInstructions() const {
+    std::vector<Instruction> program(codeSize_);
+    for (size_t i = 0; i < codeSize_; ++i) {
+        const PackedInstruction& packed = code_[i];
+        Instruction& ins = program[i];
+        ins.opcode = packed.opcode;
+        ins.args.resize(packed.argc);
+        for (size_t a = 0; a < PackedWriter::storedOperands(packed); ++a) {
+            uint32_t operand = packed.args[a];
+            if (operandIsName(packed.opcode, a, operand)) {
+                ins.args[a] = image_->names[operand & ~OperandVariable];
+            }
+            else if (operandRole(packed.opcode, a) == OperandRole::Address) {
+                std::stringstream ss;
+                ss << "0x" << std::hex << std::uppercase << operand;
+                ins.args[a] = ss.str();
+            }
+            else {
+                ins.args[a] = std::to_string(operand);
+            }
+        }
+    }
+    return program;
+}
+
+void Process::loadProgram(std::vector<Instruction> program) {
+    auto image = std::make_shared<ProgramImage>();
+    NameTable names;
+    compile(program, image->code, names);
+    image->names = std::move(names.names);
+    const PackedInstruction* code = image->code.data();
+    size_t count = image->code.size();
+    loadProgram(std::move(image), code, count);
+}
+
+void Process::loadProgram(std::shared_ptr<const ProgramImage> image, const PackedInstruction* code, size_t count) {
+    image_ = std::move(image);
+    code_ = code;
+    codeSize_ = count;
     logs_.clear();
     vars.clear();
     loopStack.clear();
     insCount_ = 0;
+    costIndexBuilt_ = false;
+}
 
+void Process::genRandInst(uint64_t min_ins, uint64_t max_ins, double memOpRatio) {
     std::uniform_int_distribution<uint64_t> distInstructions(min_ins, max_ins);
     uint64_t totalInstructions = distInstructions(gen);
 
@@ -141,6 +295,22 @@ void Process::genRandInst(uint64_t min_ins, uint64_t max_ins) {
     std::vector<int> opcode_pool = { 1, 2, 3, 4, 5 };
     std::uniform_int_distribution<int> distGeneralOp(0, static_cast<int>(opcode_pool.size()) - 1);
 
+    // READ/WRITE target even addresses inside the process's memory
+    int memBytes = memorySize_ > 0 ? memorySize_ : 64;
+    std::uniform_int_distribution<int> distAddress(0, std::max(0, memBytes / 2 - 1));
+    auto drawGeneralOp = [&]() -> int {
+        if (memOpRatio > 0.0 && distProbability(gen) < memOpRatio) {
+            return distProbability(gen) < 0.5 ? 8 : 9;
+        }
+        return opcode_pool[distGeneralOp(gen)];
+        };
+    auto addressArg = [&]() -> std::string {
+        std::stringstream ss;
+        ss << "0x" << std::hex << std::uppercase << distAddress(gen) * 2;
+        return ss.str();
+        };
+
+    std::vector<Instruction> program;
     int currentDepth = 0;
     uint64_t instructionsGenerated = 0;
 
@@ -154,7 +324,7 @@ void Process::genRandInst(uint64_t min_ins, uint64_t max_ins) {
             opcode = 6;
         }
         else {
-            opcode = opcode_pool[distGeneralOp(gen)];
+            opcode = drawGeneralOp();
         }
 
         Instruction ins;
@@ -182,11 +352,21 @@ void Process::genRandInst(uint64_t min_ins, uint64_t max_ins) {
             ins.args.push_back(std::to_string(distSleepTicks(gen)));
             break;
 
+        case 8:
+            ins.args.push_back(varPool[distVar(gen)]);
+            ins.args.push_back(addressArg());
+            break;
+
+        case 9:
+            ins.args.push_back(addressArg());
+            ins.args.push_back(varPool[distVar(gen)]);
+            break;
+
         case 6: {
             // FOR loop
             std::uniform_int_distribution<int> distRepeats(1, 5);
             ins.args.push_back(std::to_string(distRepeats(gen)));
-            insList.push_back(ins); // FOR
+            program.push_back(ins); // FOR
             instructionsGenerated++;
             currentDepth++;
 
@@ -204,7 +384,7 @@ void Process::genRandInst(uint64_t min_ins, uint64_t max_ins) {
                     innerOpcode = 6;
                 }
                 else {
-                    innerOpcode = opcode_pool[distGeneralOp(gen)];
+                    innerOpcode = drawGeneralOp();
                 }
 
                 if (innerOpcode == 6 && currentDepth >= 3) continue;
@@ -227,22 +407,30 @@ void Process::genRandInst(uint64_t min_ins, uint64_t max_ins) {
                 case 5:
                     body.args.push_back(std::to_string(distSleepTicks(gen)));
                     break;
+                case 8:
+                    body.args.push_back(varPool[distVar(gen)]);
+                    body.args.push_back(addressArg());
+                    break;
+                case 9:
+                    body.args.push_back(addressArg());
+                    body.args.push_back(varPool[distVar(gen)]);
+                    break;
                 }
 
-                insList.push_back(body);
+                program.push_back(body);
                 instructionsGenerated++;
             }
 
             Instruction endIns;
             endIns.opcode = 7; // END
-            insList.push_back(endIns);
+            program.push_back(endIns);
             instructionsGenerated++;
             currentDepth--;
             continue;
         }
         }
 
-        insList.push_back(ins);
+        program.push_back(ins);
         instructionsGenerated++;
     }
 
@@ -250,20 +438,268 @@ void Process::genRandInst(uint64_t min_ins, uint64_t max_ins) {
     while (currentDepth > 0 && instructionsGenerated < totalInstructions) {
         Instruction endIns;
         endIns.opcode = 7;
-        insList.push_back(endIns);
+        program.push_back(endIns);
         instructionsGenerated++;
         currentDepth--;
     }
 
     // Clamp to exact instruction count, just in case
-    if (insList.size() > totalInstructions) {
-        insList.resize(totalInstructions);
+    if (program.size() > totalInstructions) {
+        program.resize(totalInstructions);
+    }
+
+    loadProgram(std::move(program));
+}
+
+void Process::ensureCostIndex() const {
+    if (costIndexBuilt_.load(std::memory_order_acquire)) return;
+    std::lock_guard<std::mutex> lock(costIndexMutex_);
+    if (costIndexBuilt_.load(std::memory_order_relaxed)) return;
+    buildCostIndex();
+    costIndexBuilt_.store(true, std::memory_order_release);
+}
+
+// One pass each way, allocating only what it keeps
+void Process::buildCostIndex() const {
+    size_t n = codeSize_;
+    loopFors_.clear();
+    loopEnds_.clear();
+
+    // Mirror execute(): a FOR without exactly one argument, or one nested
+    // deeper than three, is a no-op and does not own an END
+    size_t open[3];     // positions in loopFors_
+    size_t depth = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (code_[i].opcode == 6) {
+            if (code_[i].argc == 1 && depth < 3) open[depth++] = loopFors_.size();
+            loopFors_.push_back(i);
+            loopEnds_.push_back(-1);
+        }
+        else if (code_[i].opcode == 7 && depth > 0) {
+            loopEnds_[open[--depth]] = static_cast<int>(i);
+        }
     }
+    loopPasses_ = std::vector<std::atomic<uint64_t>>(loopFors_.size());
+
+    // Walk backwards so each FOR sees the finished cost of its body and of
+    // everything after its END. An END stops the chain of its block.
+    chainCost_.assign(n + 1, 0);
+    size_t loop = loopFors_.size();
+    for (size_t k = n; k-- > 0;) {
+        const PackedInstruction& ins = code_[k];
+        int end = ins.opcode == 6 ? loopEnds_[--loop] : -1;
+        if (ins.opcode == 7) {
+            chainCost_[k] = 0;
+        }
+        else if (end >= 0) {
+            // A variable count is not known until it runs; assume one pass
+            uint64_t repeats = (ins.args[0] & OperandVariable) ? 1 : ins.args[0];
+            if (repeats < 1) repeats = 1;
+            if (repeats > 1000) repeats = 1000;
+            // FOR once, then the body and its END once per repeat
+            uint64_t unit = 1 + repeats * (chainCost_[k + 1] + 1);
+            chainCost_[k] = unit + chainCost_[end + 1];
+        }
+        else {
+            chainCost_[k] = 1 + chainCost_[k + 1];
+        }
+    }
+}
+
+int Process::loopSlot(size_t forIndex) const {
+    auto slot = std::lower_bound(loopFors_.begin(), loopFors_.end(), forIndex);
+    if (slot == loopFors_.end() || *slot != forIndex) return -1;
+    return static_cast<int>(slot - loopFors_.begin());
 }
 
+std::vector<std::pair<size_t, uint64_t>> Process::getLoopIterations() const {
+    ensureCostIndex();
+    std::vector<std::pair<size_t, uint64_t>> loops;
+    loops.reserve(loopFors_.size());
+    for (size_t i = 0; i < loopFors_.size(); ++i) {
+        loops.emplace_back(loopFors_[i], loopPasses_[i].load(std::memory_order_relaxed));
+    }
+    return loops;
+}
 
+uint64_t Process::getRemainingWork() const {
+    if (finished_) return 0;
+    ensureCostIndex();
+
+    size_t pos = insCount_ < codeSize_ ? insCount_ : codeSize_;
+    uint64_t remaining = 0;
+    // Innermost loop first: rest of this pass, its END, then the remaining passes
+    for (auto it = loopStack.rbegin(); it != loopStack.rend(); ++it) {
+        int slot = loopSlot(it->startIns - 1);
+        if (slot < 0 || loopEnds_[slot] < 0) break;
+        size_t endIndex = static_cast<size_t>(loopEnds_[slot]);
+        uint64_t passes = it->repeats > 0 ? it->repeats - 1 : 0;
+        remaining += chainCost_[pos] + 1 + passes * (chainCost_[it->startIns] + 1);
+        pos = endIndex + 1;
+    }
+    return remaining + chainCost_[pos];
+}
 
-bool Process::runOneInstruction(int coreId) {
+
+
+void Process::writeState(PackedWriter& out) const {
+    out.putString(name_);
+    out.putVarint((finished_ ? 1u : 0u) | (isSleeping_ ? 2u : 0u) | (inMemory_ ? 4u : 0u) | (dispatched_ ? 8u : 0u));
+    out.putVarint(sleepTargetTick_);
+    out.putSigned(lastCoreId_);
+    out.putSigned(static_cast<int64_t>(finishTime_));
+
+    out.putVarint(insCount_);
+    out.putVarint(vars.size());
+    for (const auto& v : vars) {
+        out.putString(v.first);
+        out.putVarint(v.second);
+    }
+    out.putVarint(loopStack.size());
+    for (const auto& loop : loopStack) {
+        out.putVarint(loop.startIns);
+        out.putVarint(loop.repeats);
+    }
+    out.putVarint(logs_.size());
+    for (const auto& log : logs_) {
+        out.putSigned(static_cast<int64_t>(log.first));
+        out.putString(log.second);
+    }
+    for (const auto& count : opcodeCounts_) out.putVarint(count.load(std::memory_order_relaxed));
+    out.putVarint(loopBodyInstructions_.load(std::memory_order_relaxed));
+    // No index yet means no loop has finished a pass
+    if (costIndexBuilt_.load(std::memory_order_acquire)) {
+        out.putVarint(loopPasses_.size());
+        for (const auto& passes : loopPasses_) out.putVarint(passes.load(std::memory_order_relaxed));
+    }
+    else {
+        out.putVarint(0);
+    }
+
+    out.putSigned(memorySize_);
+    out.putSigned(schedLevel_);
+    out.putVarint(boostEpoch_);
+    out.putVarint(readyTick_);
+    out.putVarint(arrivalTick_);
+    out.putVarint(finishTick_);
+    out.putVarint(arrivalNanos_);
+    out.putVarint(finishNanos_);
+    out.putVarint(firstDispatch_.ticks);
+    out.putVarint(firstDispatch_.nanos);
+    out.putVarint(readySince_.ticks);
+    out.putVarint(readySince_.nanos);
+    out.putVarint(waitTotal_.ticks);
+    out.putVarint(waitTotal_.nanos);
+    out.putVarint(runTotal_.ticks);
+    out.putVarint(runTotal_.nanos);
+    out.putString(group_);
+    out.putVarint(relativeDeadline_);
+    out.putVarint(deadline_);
+    out.putVarint(cpuTicks_);
+    out.putVarint(chargedTicks_);
+}
+
+bool Process::readState(PackedReader& in, uint64_t tickOffset, uint64_t checkpointNanos) {
+    uint64_t flags, count, value;
+    int64_t signedValue;
+    if (!in.getString(name_) || !in.getVarint(flags) || !in.getVarint(sleepTargetTick_)) return false;
+    finished_ = (flags & 1) != 0;
+    isSleeping_ = (flags & 2) != 0;
+    inMemory_ = (flags & 4) != 0;
+    dispatched_ = (flags & 8) != 0;
+    if (!in.getSigned(signedValue)) return false;
+    lastCoreId_ = static_cast<int>(signedValue);
+    if (!in.getSigned(signedValue)) return false;
+    finishTime_ = static_cast<time_t>(signedValue);
+
+    if (!in.getVarint(value) || value > codeSize_) return false;
+    insCount_ = static_cast<size_t>(value);
+
+    vars.clear();
+    if (!in.getVarint(count)) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string key;
+        if (!in.getString(key) || !in.getVarint(value)) return false;
+        vars[key] = static_cast<uint16_t>(value);
+    }
+    loopStack.clear();
+    if (!in.getVarint(count) || count > 3) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        uint64_t start, repeats;
+        if (!in.getVarint(start) || !in.getVarint(repeats) || start > codeSize_) return false;
+        loopStack.push_back({ static_cast<size_t>(start), static_cast<uint16_t>(repeats) });
+    }
+    logs_.clear();
+    if (!in.getVarint(count)) return false;
+    for (uint64_t i = 0; i < count; ++i) {
+        std::string message;
+        if (!in.getSigned(signedValue) || !in.getString(message)) return false;
+        logs_.emplace_back(static_cast<time_t>(signedValue), std::move(message));
+    }
+    for (auto& c : opcodeCounts_) {
+        if (!in.getVarint(value)) return false;
+        c.store(value, std::memory_order_relaxed);
+    }
+    if (!in.getVarint(value)) return false;
+    loopBodyInstructions_.store(value, std::memory_order_relaxed);
+    if (!in.getVarint(count)) return false;
+    if (count > 0) {
+        ensureCostIndex();
+        if (count != loopPasses_.size()) return false;
+        for (auto& passes : loopPasses_) {
+            if (!in.getVarint(value)) return false;
+            passes.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    if (!in.getSigned(signedValue)) return false;
+    memorySize_ = static_cast<int>(signedValue);
+    if (!in.getSigned(signedValue)) return false;
+    schedLevel_ = static_cast<int>(signedValue);
+    if (!in.getVarint(boostEpoch_) || !in.getVarint(readyTick_) || !in.getVarint(arrivalTick_)
+        || !in.getVarint(finishTick_) || !in.getVarint(arrivalNanos_) || !in.getVarint(finishNanos_)
+        || !in.getVarint(firstDispatch_.ticks) || !in.getVarint(firstDispatch_.nanos)
+        || !in.getVarint(readySince_.ticks) || !in.getVarint(readySince_.nanos)
+        || !in.getVarint(waitTotal_.ticks) || !in.getVarint(waitTotal_.nanos)
+        || !in.getVarint(runTotal_.ticks) || !in.getVarint(runTotal_.nanos)
+        || !in.getString(group_) || !in.getVarint(relativeDeadline_) || !in.getVarint(deadline_)
+        || !in.getVarint(cpuTicks_) || !in.getVarint(chargedTicks_)) {
+        return false;
+    }
+
+    // Ticks move forward by the same amount everywhere, so differences hold.
+    // A zero deadline or sleep target means none and stays zero.
+    readyTick_ += tickOffset;
+    arrivalTick_ += tickOffset;
+    readySince_.ticks += tickOffset;
+    if (finished_) finishTick_ += tickOffset;
+    if (dispatched_) firstDispatch_.ticks += tickOffset;
+    if (isSleeping_) sleepTargetTick_ += tickOffset;
+    if (deadline_ != 0) deadline_ += tickOffset;
+
+    // Steady-clock values are kept as their age at checkpoint time and
+    // re-anchored to now; an age older than this run's clock clamps to 0
+    uint64_t now = steadyNanos();
+    auto rebase = [&](uint64_t& nanos) {
+        uint64_t age = since(nanos, checkpointNanos);
+        nanos = age < now ? now - age : 0;
+    };
+    rebase(arrivalNanos_);
+    rebase(readySince_.nanos);
+    if (finished_) rebase(finishNanos_);
+    if (dispatched_) rebase(firstDispatch_.nanos);
+    return true;
+}
+
+const char* Process::opcodeName(uint8_t opcode) {
+    static const char* const names[OpcodeCount] = {
+        "UNKNOWN", "DECLARE", "ADD", "SUBTRACT", "PRINT", "SLEEP", "FOR", "END", "READ", "WRITE"
+    };
+    return opcode < OpcodeCount ? names[opcode] : names[0];
+}
+
+bool Process::runOneInstruction(int coreId, Executed* executed) {
+    if (executed) *executed = Executed();
     if (finished_) return false;
 
     if (isSleeping_) {
@@ -276,18 +712,29 @@ bool Process::runOneInstruction(int coreId) {
         }
     }
 
-    if (insCount_ >= insList.size()) {
+    if (insCount_ >= codeSize_) {
         finished_ = true;
         return false;
     }
 
-    execute(insList[insCount_], coreId);
+    uint8_t opcode = code_[insCount_].opcode;
+    bool inLoop = !loopStack.empty();
+    execute(code_[insCount_], coreId);
+
+    if (opcode < OpcodeCount) opcodeCounts_[opcode].fetch_add(1, std::memory_order_relaxed);
+    if (inLoop) loopBodyInstructions_.fetch_add(1, std::memory_order_relaxed);
+    if (executed) {
+        executed->opcode = opcode;
+        executed->inLoop = inLoop;
+        executed->iteration = opcode == 7 && inLoop;   // every END with an open loop ends a pass
+    }
+    if (finished_) return false;  // terminated by an access violation
 
     if (!isSleeping_) {
         insCount_++;
     }
 
-    if (insCount_ >= insList.size()) {
+    if (insCount_ >= codeSize_) {
         finished_ = true;
         return false;
     }
@@ -335,7 +782,7 @@ std::string Process::smi() const {
     }
 
     ss << "Current instruction line: " << insCount_ << "\n";
-    ss << "Lines of code: " << insList.size() << "\n";
+    ss << "Lines of code: " << codeSize_ << "\n";
 
     return ss.str();
 }
\ No newline at end of file
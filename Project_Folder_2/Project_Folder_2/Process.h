@@ -4,6 +4,14 @@
 #include <unordered_map>
 #include <memory>
 #include <cstdint>
+#include <atomic>
+#include <mutex>
+
+#include "Bytecode.h"
+
+class MemoryManager;
+class PackedWriter;
+class PackedReader;
 
 class Process {
 public:
@@ -12,6 +20,10 @@ public:
         std::vector<std::string> args;
     };
 
+    // Opcodes 1-9: DECLARE, ADD, SUBTRACT, PRINT, SLEEP, FOR, END, READ, WRITE
+    static const int OpcodeCount = 10;
+    static const char* opcodeName(uint8_t opcode);   // "UNKNOWN" outside 1-9
+
     struct LoopState {
         size_t startIns;
         uint16_t repeats;
@@ -25,13 +37,16 @@ public:
     bool isSleeping() const { return isSleeping_; }
     uint64_t getSleepTargetTick() const { return sleepTargetTick_; }
     size_t getCurrentInstructionIndex() const { return insCount_; }
-    size_t getTotalInstructions() const { return insList.size(); }
+    size_t getTotalInstructions() const { return codeSize_; }
     const std::vector<std::pair<time_t, std::string>>& getLogs() const {
         return logs_;
     }
 
     void setLastCoreId(int id) { lastCoreId_ = id; }
     int getLastCoreId() const { return lastCoreId_; }
+    // Value of that core's dispatch counter when p last started there
+    void setLastCoreSeq(uint64_t seq) { lastCoreSeq_ = seq; }
+    uint64_t getLastCoreSeq() const { return lastCoreSeq_; }
 
     void setFinishTime(time_t t) { finishTime_ = t; }
     time_t getFinishTime() const { return finishTime_; }
@@ -39,9 +54,42 @@ public:
     const std::unordered_map<std::string, uint16_t>& getVariables() const { return vars; }
 
     std::string smi() const;
-    void execute(const Instruction& ins, int coreId = -1);
-    void genRandInst(uint64_t min_ins, uint64_t max_ins);
-    bool runOneInstruction(int coreId = -1);
+    void execute(const PackedInstruction& ins, int coreId = -1);
+    // memOpRatio is the share of READ/WRITE among the non-FOR instructions
+    void genRandInst(uint64_t min_ins, uint64_t max_ins, double memOpRatio = 0.0);
+    // Replaces the program with a given one (a replayed workload) and resets
+    // execution state, as genRandInst does
+    void loadProgram(std::vector<Instruction> program);
+    // Runs count instructions at code in place; image keeps them alive
+    void loadProgram(std::shared_ptr<const ProgramImage> image, const PackedInstruction* code, size_t count);
+    // The program in text form, rebuilt from the bytecode. Tokens come back
+    // normalized ("007" as "7", addresses in hex) with the same meaning.
+    std::vector<Instruction> getInstructions() const;
+    // The bytecode itself (getTotalInstructions() long) and its name table
+    const PackedInstruction* getCode() const { return code_; }
+    const std::shared_ptr<const ProgramImage>& getProgramImage() const { return image_; }
+
+    // Appends the bytecode of program to code, interning its variable names.
+    // Operands are resolved exactly as the text interpreter did: a value
+    // token starting with a digit, or '-' and more, is a number cast to 16
+    // bits (0 if it does not parse), anything else names a variable; an
+    // address is parsed with base prefixes and is UINT32_MAX if invalid.
+    static void compile(const std::vector<Instruction>& program, std::vector<PackedInstruction>& code,
+        NameTable& names);
+    // What runOneInstruction ran, for the per-core counters
+    struct Executed {
+        uint8_t opcode = 0;         // 0 when nothing ran
+        bool inLoop = false;        // a FOR body was open
+        bool iteration = false;     // END that finished one pass of a loop body
+    };
+    bool runOneInstruction(int coreId = -1, Executed* executed = nullptr);
+
+    // Instruction mix of this process. Written by the core running it and
+    // read relaxed, so counts read together may be a few instructions apart.
+    uint64_t getOpcodeCount(int opcode) const { return opcodeCounts_[opcode].load(std::memory_order_relaxed); }
+    uint64_t getLoopBodyInstructions() const { return loopBodyInstructions_.load(std::memory_order_relaxed); }
+    // (FOR index, finished passes of its body) for every FOR, in program order
+    std::vector<std::pair<size_t, uint64_t>> getLoopIterations() const;
     void setIsSleeping(bool val, uint64_t targetTick = 0) {
         isSleeping_ = val;
         sleepTargetTick_ = targetTick;
@@ -50,6 +98,78 @@ public:
     bool isInMemory() const;
     void setInMemory(bool value);
 
+    // Bytes of memory the process needs; 0 means the allocator default
+    int getMemorySize() const { return memorySize_; }
+    void setMemorySize(int bytes) { memorySize_ = bytes; }
+
+    // Memory that READ/WRITE go through; set when the process is admitted
+    void attachMemory(MemoryManager* memory) { memory_ = memory; }
+
+    // Scheduler bookkeeping
+    int getSchedLevel() const { return schedLevel_; }
+    void setSchedLevel(int level) { schedLevel_ = level; }
+    uint64_t getBoostEpoch() const { return boostEpoch_; }
+    void setBoostEpoch(uint64_t epoch) { boostEpoch_ = epoch; }
+    uint64_t getReadyTick() const { return readyTick_; }   // tick it last entered a ready queue
+    void setReadyTick(uint64_t tick) { readyTick_ = tick; }
+    uint64_t getArrivalTick() const { return arrivalTick_; }
+    uint64_t getFinishTick() const { return finishTick_; }
+
+    // Lifecycle timing, each in CPU ticks and steady-clock nanoseconds. Wait
+    // is time spent runnable but off a core, waiting for memory included;
+    // run is time on a core, warm-up and migration penalties included.
+    // Sleeping counts as neither.
+    struct Timing {
+        uint64_t ticks = 0;
+        uint64_t nanos = 0;
+    };
+    void markArrival(uint64_t tick);        // also starts the first wait
+    void markReady(uint64_t tick);          // requeued or woken up
+    void markDispatched(uint64_t tick);
+    void markDescheduled(uint64_t tick);
+    void markFinished(uint64_t tick);
+    bool hasBeenDispatched() const { return dispatched_; }
+    Timing getResponseTime() const;         // arrival to first dispatch
+    Timing getTurnaroundTime() const;       // arrival to finish
+    Timing getTotalWait() const { return waitTotal_; }
+    Timing getTotalRun() const { return runTotal_; }
+
+    // Deadline relative to arrival, in ticks; 0 means none. The scheduler
+    // turns it into an absolute tick when the process is submitted.
+    uint64_t getRelativeDeadline() const { return relativeDeadline_; }
+    void setRelativeDeadline(uint64_t ticks) { relativeDeadline_ = ticks; }
+    bool hasDeadline() const { return deadline_ != 0; }
+    uint64_t getDeadline() const { return deadline_; }
+    void setDeadline(uint64_t tick) { deadline_ = tick; }
+
+    // Fair-share group ("" means the default group)
+    const std::string& getGroup() const { return group_; }
+    void setGroup(const std::string& group) { group_ = group; }
+    // Core ticks spent running this process, and how many of them have been
+    // charged to its group
+    uint64_t getCpuTicks() const { return cpuTicks_; }
+    void addCpuTicks(uint64_t ticks) { cpuTicks_ += ticks; }
+    uint64_t getChargedTicks() const { return chargedTicks_; }
+    void setChargedTicks(uint64_t ticks) { chargedTicks_ = ticks; }
+
+    // Instructions still to execute with FOR bodies expanded; O(loop depth)
+    // once the cost index is built. Only while the process is not running.
+    uint64_t getRemainingWork() const;
+    // getRemainingWork as of the last quantum boundary, for readers that may
+    // see the process running on a core
+    uint64_t getRemainingWorkSnapshot() const { return remainingWorkSnapshot_.load(std::memory_order_relaxed); }
+    void snapshotRemainingWork() { remainingWorkSnapshot_.store(getRemainingWork(), std::memory_order_relaxed); }
+
+    // Checkpoint support. writeState records everything but the pid and the
+    // program, which the caller stores itself, and the attached memory.
+    // readState loads it into a freshly constructed process whose program
+    // the caller has already loaded, moving tick fields forward by
+    // tickOffset and re-anchoring steady-clock fields so that time the
+    // emulator was down does not count as waiting or running; checkpointNanos
+    // is the steady clock when the checkpoint was taken.
+    void writeState(PackedWriter& out) const;
+    bool readState(PackedReader& in, uint64_t tickOffset, uint64_t checkpointNanos);
+
 private:
     int pid_;
     std::string name_;
@@ -57,12 +177,55 @@ private:
     bool isSleeping_ = false;
     uint64_t sleepTargetTick_ = 0;
     int lastCoreId_ = -1;  // -1 means unassigned or unknown
+    uint64_t lastCoreSeq_ = 0;
     time_t finishTime_ = 0;
-    std::vector<Instruction> insList;
+    std::shared_ptr<const ProgramImage> image_;
+    const PackedInstruction* code_ = nullptr;     // into image_
+    size_t codeSize_ = 0;
     size_t insCount_ = 0;
     std::unordered_map<std::string, uint16_t> vars;
     std::vector<LoopState> loopStack;
     std::vector<std::pair<time_t, std::string>> logs_;
+    std::atomic<uint64_t> opcodeCounts_[OpcodeCount] = {};
+    std::atomic<uint64_t> loopBodyInstructions_{ 0 };
+    // The loop and cost index of the program, built by ensureCostIndex() the
+    // first time something needs it rather than when the program is loaded:
+    // a process can wait a long time for memory first, and a restore loads
+    // many processes at once. loopFors_ holds the index of every FOR,
+    // ascending, loopEnds_ the END closing each (or -1) and loopPasses_ the
+    // finished passes of each. chainCost_[i] is the expanded cost of running
+    // from i up to the END of the enclosing block.
+    void ensureCostIndex() const;   // any thread
+    void buildCostIndex() const;
+    int loopSlot(size_t forIndex) const;    // position in loopFors_, or -1
+    mutable std::mutex costIndexMutex_;
+    mutable std::atomic<bool> costIndexBuilt_{ false };
+    mutable std::vector<size_t> loopFors_;
+    mutable std::vector<int> loopEnds_;
+    mutable std::vector<std::atomic<uint64_t>> loopPasses_;
+    mutable std::vector<uint64_t> chainCost_;
+    std::atomic<uint64_t> remainingWorkSnapshot_{ 0 };
 
     bool inMemory_ = false;
+    int memorySize_ = 0;
+    MemoryManager* memory_ = nullptr;
+
+    int schedLevel_ = 0;
+    uint64_t boostEpoch_ = 0;
+    uint64_t readyTick_ = 0;
+    uint64_t arrivalTick_ = 0;
+    uint64_t finishTick_ = 0;
+    uint64_t arrivalNanos_ = 0;
+    uint64_t finishNanos_ = 0;
+    Timing firstDispatch_;
+    Timing readySince_;
+    Timing runningSince_;
+    Timing waitTotal_;
+    Timing runTotal_;
+    bool dispatched_ = false;
+    std::string group_;
+    uint64_t relativeDeadline_ = 0;
+    uint64_t deadline_ = 0;
+    uint64_t cpuTicks_ = 0;
+    uint64_t chargedTicks_ = 0;
 };
\ No newline at end of file
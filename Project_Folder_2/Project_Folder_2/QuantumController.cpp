@@ -0,0 +1,94 @@
+#include "QuantumController.h"
+#include <cmath>
+
+namespace {
+const double SmoothingWeight = 0.2;  // weight of the newest sample
+}
+
+QuantumController::QuantumController(uint64_t initialQuantum, uint64_t minQuantum,
+    uint64_t maxQuantum, uint64_t responseTargetTicks, double maxOverhead, uint64_t adjustTicks,
+    const std::string& logPath)
+    : quantum_(initialQuantum), minQuantum_(minQuantum < 1 ? 1 : minQuantum),
+    maxQuantum_(maxQuantum), responseTarget_(responseTargetTicks), maxOverhead_(maxOverhead),
+    adjustTicks_(adjustTicks < 1 ? 1 : adjustTicks),
+    lastAdjustTime_(std::chrono::steady_clock::now()) {
+    if (maxQuantum_ < minQuantum_) maxQuantum_ = minQuantum_;
+    if (quantum_ < minQuantum_) quantum_ = minQuantum_;
+    if (quantum_ > maxQuantum_) quantum_ = maxQuantum_;
+    if (!logPath.empty()) {
+        log_.open(logPath, std::ios::trunc);
+        if (log_) log_ << "# tick old new depth switch_ns ns_per_tick reason\n";
+    }
+}
+
+void QuantumController::recordDispatch(uint64_t nanos) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    switchNanos_ = switchNanos_ == 0.0 ? static_cast<double>(nanos)
+        : switchNanos_ + SmoothingWeight * (static_cast<double>(nanos) - switchNanos_);
+}
+
+void QuantumController::update(uint64_t now, size_t readyDepth, int cores) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (now - lastAdjustTick_ < adjustTicks_) return;
+
+    auto wallNow = std::chrono::steady_clock::now();
+    double elapsed = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(wallNow - lastAdjustTime_).count());
+    double perTick = elapsed / static_cast<double>(now - lastAdjustTick_);
+    nanosPerTick_ = nanosPerTick_ == 0.0 ? perTick
+        : nanosPerTick_ + SmoothingWeight * (perTick - nanosPerTick_);
+    lastAdjustTick_ = now;
+    lastAdjustTime_ = wallNow;
+    lastDepth_ = readyDepth;
+
+    double target = static_cast<double>(maxQuantum_);
+    const char* reason = "response";
+    if (readyDepth > 0 && cores > 0) {
+        target = static_cast<double>(responseTarget_) * cores / static_cast<double>(readyDepth);
+    }
+    if (nanosPerTick_ > 0.0 && maxOverhead_ > 0.0 && maxOverhead_ < 1.0) {
+        double switchTicks = switchNanos_ / nanosPerTick_;
+        double floor = std::ceil(switchTicks * (1.0 - maxOverhead_) / maxOverhead_);
+        if (target < floor) {
+            target = floor;
+            reason = "overhead";
+        }
+    }
+    if (target < static_cast<double>(minQuantum_)) {
+        target = static_cast<double>(minQuantum_);
+        reason = "min";
+    }
+    if (target > static_cast<double>(maxQuantum_)) {
+        target = static_cast<double>(maxQuantum_);
+        reason = "max";
+    }
+
+    uint64_t next = static_cast<uint64_t>(target);
+    uint64_t cur = quantum_.load();
+    uint64_t diff = next > cur ? next - cur : cur - next;
+    // Ignore small moves unless a bound is reached
+    bool atBound = next == minQuantum_ || next == maxQuantum_;
+    if (diff == 0 || (diff * 5 < cur && !atBound)) return;
+
+    quantum_ = next;
+    changes_++;
+    logChange(now, cur, next, reason);
+}
+
+void QuantumController::logChange(uint64_t now, uint64_t from, uint64_t to, const char* reason) {
+    if (!log_) return;
+    log_ << now << ' ' << from << ' ' << to << ' ' << lastDepth_ << ' '
+        << static_cast<uint64_t>(switchNanos_) << ' ' << nanosPerTick_ << ' ' << reason << '\n';
+    log_.flush();
+}
+
+QuantumStats QuantumController::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    QuantumStats st;
+    st.quantum = quantum_.load();
+    st.changes = changes_;
+    st.switchNanos = switchNanos_;
+    st.nanosPerTick = nanosPerTick_;
+    st.readyDepth = lastDepth_;
+    return st;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+struct QuantumStats {
+    uint64_t quantum = 0;
+    uint64_t changes = 0;
+    double   switchNanos = 0.0;   // smoothed cost of handing a process to a core
+    double   nanosPerTick = 0.0;  // smoothed wall time of one CPU tick
+    size_t   readyDepth = 0;      // at the last adjustment
+};
+
+// Adaptive round-robin quantum. Every adjustTicks the quantum is recomputed
+// from two limits and clamped to [minQuantum, maxQuantum]:
+//  - response: a newly queued process waits about depth * q / cores ticks,
+//    so q is capped at responseTarget * cores / depth;
+//  - overhead: dispatch cost s (in ticks) takes s / (q + s) of a core, so q
+//    is raised to keep that at or below maxOverhead. Overhead wins over the
+//    response target, otherwise a deep queue would be served mostly by
+//    context switches.
+// Changes of less than 20% are ignored. Every change is appended to a text log.
+class QuantumController {
+public:
+    QuantumController(uint64_t initialQuantum, uint64_t minQuantum, uint64_t maxQuantum,
+        uint64_t responseTargetTicks, double maxOverhead, uint64_t adjustTicks,
+        const std::string& logPath);
+
+    uint64_t current() const { return quantum_.load(); }
+
+    // Wall time the scheduler spent starting one dispatch
+    void recordDispatch(uint64_t nanos);
+
+    // Called once per scheduler pass; adjusts at most once per adjustTicks
+    void update(uint64_t now, size_t readyDepth, int cores);
+
+    QuantumStats getStats() const;
+
+private:
+    void logChange(uint64_t now, uint64_t from, uint64_t to, const char* reason);
+
+    std::atomic<uint64_t> quantum_;
+    uint64_t minQuantum_;
+    uint64_t maxQuantum_;
+    uint64_t responseTarget_;
+    double   maxOverhead_;
+    uint64_t adjustTicks_;
+
+    mutable std::mutex mutex_;
+    std::ofstream log_;
+    double switchNanos_ = 0.0;
+    double nanosPerTick_ = 0.0;
+    uint64_t changes_ = 0;
+    size_t lastDepth_ = 0;
+    uint64_t lastAdjustTick_ = 0;
+    std::chrono::steady_clock::time_point lastAdjustTime_;
+};
@@ -1,27 +1,44 @@
 #include "Scheduler.h"
 #include "Core.h"
+#include "MappedFile.h"
+#include "PackedCodec.h"
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <random>
 #include <iostream>
+#include <sstream>
+#include <unordered_map>
 
 static std::random_device scheduler_rd;
 static std::mt19937 scheduler_gen(scheduler_rd());
+// The generator, console, replay and corpus-build threads all draw from it
+static std::mutex scheduler_gen_mutex;
 
 Scheduler::Scheduler(int num_cpu, const std::string& scheduler_type, uint64_t quantum_cycles,
     uint64_t batch_process_freq, uint64_t min_ins, uint64_t max_ins, uint64_t delay_per_exec,
     MemoryManager& memoryManager)
-    : numCpus_(num_cpu), schedulerType_(scheduler_type), quantumCycles_(quantum_cycles),
+    : numCpus_(num_cpu), quantumCycles_(quantum_cycles),
     batchProcessFreq_(batch_process_freq), minInstructions_(min_ins), maxInstructions_(max_ins),
     delayPerExec_(delay_per_exec), running_(false), processGenEnabled_(false),
     lastProcessGenTick_(0), nextPid_(1), activeProcessesCount_(0),
-    schedulerStartTime_(0), memoryManager_(memoryManager), lastQuantumSnapshot_(0), quantumIndex_(0) {
+    schedulerStartTime_(0), memoryManager_(memoryManager), lastQuantumSnapshot_(0), quantumIndex_(0),
+    admission_(memoryManager, 100000), minMemPerProc_(memoryManager.getMemPerProc()),
+    maxMemPerProc_(memoryManager.getMemPerProc()), tracer_(num_cpu) {
 
     cores_.reserve(numCpus_);
     for (int i = 0; i < numCpus_; ++i) {
         cores_.emplace_back(std::make_unique<Core>(i, this, delayPerExec_));
         coreTicksUsed_.emplace_back(std::make_unique<std::atomic<uint64_t>>(0));
     }
+    holds_.resize(numCpus_);
+    utilization_.configure(static_cast<size_t>(numCpus_));
+    busySample_.resize(numCpus_);
+
+    policy_ = makeSchedulingPolicy(scheduler_type, policySettings());
+    if (!policy_) policy_ = makeSchedulingPolicy("fcfs", policySettings());
 }
 
 Scheduler::~Scheduler() {
@@ -44,6 +61,11 @@ void Scheduler::stop() {
         }
     }
 
+    // The exporter renders from scheduler state, so it goes first
+    if (metrics_) metrics_->stop();
+
+    stopReplay();
+
     // Stop the scheduler and process generator loops
     running_ = false;
     processGenEnabled_ = false;
@@ -58,33 +80,576 @@ void Scheduler::stop() {
 }
 
 void Scheduler::submit(std::shared_ptr<Process> p) {
-    bool success = memoryManager_.allocate(p->getPid());
-    if (success) {
-        readyQueue_.push(p);
-        activeProcessesCount_++;
+    activeProcessesCount_++;
+    prepareArrival(p, globalCpuTicks.load());
+    if (recording_.load()) recorder_.record(*p, p->getArrivalTick());
+    if (admission_.submit(p, globalCpuTicks.load())) {
+        enqueueReady(p);
+    }
+    else if (tracer_.enabled()) {
+        tracer_.record(tracer_.arrivalRing(), TraceEventType::MemoryDefer, p->getPid(), -1, globalCpuTicks.load());
+    }
+    // Otherwise the process waits in admission_ until memory frees up
+}
+
+void Scheduler::submitBatch(const std::vector<std::shared_ptr<Process>>& processes) {
+    if (processes.empty()) return;
+    uint64_t now = globalCpuTicks.load();
+    activeProcessesCount_ += static_cast<int>(processes.size());
+    for (const auto& p : processes) prepareArrival(p, now);
+    if (recording_.load()) {
+        for (const auto& p : processes) recorder_.record(*p, now);
+    }
+
+    std::vector<std::shared_ptr<Process>> admitted;
+    admission_.submitMany(processes, now, admitted);
+    if (tracer_.enabled() && admitted.size() < processes.size()) {
+        // admitted keeps submission order, so the rest were deferred
+        size_t next = 0;
+        for (const auto& p : processes) {
+            if (next < admitted.size() && admitted[next] == p) next++;
+            else tracer_.record(tracer_.arrivalRing(), TraceEventType::MemoryDefer, p->getPid(), -1, now);
+        }
+    }
+    enqueueReadyMany(admitted);
+}
+
+// Stamps the arrival tick and turns a relative deadline into an absolute one,
+// subject to the EDF admission test
+void Scheduler::prepareArrival(const std::shared_ptr<Process>& p, uint64_t now) {
+    p->markArrival(now);
+    if (p->getRelativeDeadline() == 0) return;
+
+    // p has not run yet and can be asked directly; the others may be on a
+    // core, so the test takes their work as of their last quantum boundary
+    p->snapshotRemainingWork();
+    std::lock_guard<ProfiledMutex> lock(deadlineMutex_);
+    if (deadlineAdmissionTest_) {
+        // Until a rate has been measured assume one instruction per delay-per-exec ticks
+        double rate = instrPerCoreTick_ > 0.0 ? instrPerCoreTick_
+            : 1.0 / static_cast<double>(delayPerExec_ > 0 ? delayPerExec_ : 1);
+        double own = static_cast<double>(p->getRemainingWorkSnapshot()) / p->getRelativeDeadline();
+        double density = own;
+        for (const auto& other : activeDeadlines_) {
+            // Processes already past their deadline cannot be helped; leave them out
+            if (other->getDeadline() > now) {
+                density += static_cast<double>(other->getRemainingWorkSnapshot()) / (other->getDeadline() - now);
+            }
+        }
+        if (own > rate || density > densityBound_ * rate * numCpus_) {
+            deadlinesDemoted_++;
+            return;
+        }
+    }
+    p->setDeadline(now + p->getRelativeDeadline());
+    activeDeadlines_.push_back(p);
+}
+
+// Called once per scheduler pass while the admission test is on
+void Scheduler::sampleCoreRate() {
+    uint64_t now = globalCpuTicks.load();
+    uint64_t used = 0;
+    for (const auto& ticks : coreTicksUsed_) used += ticks->load();
+    int busy = 0;
+    for (const auto& core : cores_) {
+        if (core->isBusy()) busy++;
+    }
+
+    std::lock_guard<ProfiledMutex> lock(deadlineMutex_);
+    if (busy > 0 && now > lastRateTick_ && lastRateTick_ > 0) {
+        double sample = static_cast<double>(used - lastRateUsed_) / (static_cast<double>(now - lastRateTick_) * busy);
+        instrPerCoreTick_ = instrPerCoreTick_ == 0.0 ? sample : instrPerCoreTick_ + 0.1 * (sample - instrPerCoreTick_);
+    }
+    lastRateTick_ = now;
+    lastRateUsed_ = used;
+}
+
+// Reads the cores' busy counters without locking them; called once per scheduler pass
+void Scheduler::sampleUtilization() {
+    uint64_t now = globalCpuTicks.load();
+    for (size_t i = 0; i < cores_.size(); ++i) busySample_[i] = cores_[i]->getBusyTicks(now);
+    utilization_.sample(UtilizationTracker::Clock::now(), now, busySample_);
+}
+
+bool Scheduler::configureStatsSegment(const std::string& name) {
+    statsSegment_ = std::make_unique<StatsSegment>(name, static_cast<uint32_t>(numCpus_));
+    if (!statsSegment_->isOpen()) statsSegment_.reset();
+    return statsSegment_ != nullptr;
+}
+
+bool Scheduler::configureMetrics(const std::string& target, uint64_t intervalMs) {
+    if (metrics_) metrics_->stop();
+    metrics_ = std::make_unique<MetricsExporter>([this]() { return renderMetrics(); });
+    if (!metrics_->start(target, intervalMs)) metrics_.reset();
+    return metrics_ != nullptr;
+}
+
+// Prometheus text exposition format, version 0.0.4. Counters are read from
+// the atomics the cores and the scheduler bump as they go; gauges are read
+// at render time.
+std::string Scheduler::renderMetrics() {
+    std::ostringstream out;
+    auto family = [&out](const char* name, const char* type, const char* help) {
+        out << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    };
+
+    family("csopesy_dispatches_total", "counter", "Processes placed on a core.");
+    out << "csopesy_dispatches_total " << getDispatchCount() << "\n";
+
+    family("csopesy_context_switches_total", "counter",
+        "Dispatches that put a different process on a core than the one it ran last.");
+    for (const auto& core : cores_) {
+        out << "csopesy_context_switches_total{core=\"" << core->id_ << "\"} " << core->getContextSwitches() << "\n";
+    }
+
+    family("csopesy_instructions_total", "counter", "Instructions executed, by core and opcode.");
+    for (const auto& core : cores_) {
+        for (int op = 1; op < Process::OpcodeCount; ++op) {
+            out << "csopesy_instructions_total{core=\"" << core->id_ << "\",opcode=\""
+                << Process::opcodeName(static_cast<uint8_t>(op)) << "\"} " << core->getInstructionCount(op) << "\n";
+        }
+    }
+
+    family("csopesy_ready_queue_depth", "gauge", "Processes waiting for a core, affinity holds included.");
+    out << "csopesy_ready_queue_depth " << readyDepth() << "\n";
+    family("csopesy_memory_pending_processes", "gauge", "Arrivals waiting for memory.");
+    out << "csopesy_memory_pending_processes " << admission_.pendingCount() << "\n";
+    family("csopesy_sleeping_processes", "gauge", "Processes sleeping off a core.");
+    {
+        std::lock_guard<ProfiledMutex> lock(sleepingProcessesMutex_);
+        out << "csopesy_sleeping_processes " << sleepingProcesses_.size() << "\n";
+    }
+    family("csopesy_running_processes", "gauge", "Busy cores.");
+    out << "csopesy_running_processes " << getCoresUsed() << "\n";
+    family("csopesy_active_processes", "gauge", "Processes submitted and not finished.");
+    out << "csopesy_active_processes " << activeProcessesCount_.load() << "\n";
+    family("csopesy_finished_processes_total", "counter", "Processes finished.");
+    {
+        std::lock_guard<ProfiledMutex> lock(finishedProcessesMutex_);
+        out << "csopesy_finished_processes_total " << finishedProcesses_.size() << "\n";
     }
-    else {
-        memoryPendingQueue.push(p);
-        static int warnCount = 0;
-        if (warnCount < 10) {
-            // std::cout << "[MemoryManager] Process " << p->getName() << " deferred due to insufficient memory.\n";
-            warnCount++;
+
+    // No demand paging here: a page fault is a TLB miss, resolved by a page-table walk
+    family("csopesy_page_faults_total", "counter", "TLB misses that needed a page-table walk.");
+    out << "csopesy_page_faults_total " << memoryManager_.getPageWalks() << "\n";
+    family("csopesy_tlb_hits_total", "counter", "Software TLB hits on READ/WRITE.");
+    out << "csopesy_tlb_hits_total " << memoryManager_.getTlbHits() << "\n";
+
+    static const char* const windowNames[] = { "1s", "10s", "60s" };
+    auto windows = utilization_.get();
+    family("csopesy_cpu_utilization_ratio", "gauge", "Busy share of all cores over a time window.");
+    for (size_t w = 0; w < windows.size() && w < 3; ++w) {
+        out << "csopesy_cpu_utilization_ratio{window=\"" << windowNames[w] << "\"} " << windows[w].total / 100.0 << "\n";
+    }
+    family("csopesy_core_utilization_ratio", "gauge", "Busy share of one core over a time window.");
+    for (size_t w = 0; w < windows.size() && w < 3; ++w) {
+        for (size_t i = 0; i < windows[w].perCore.size(); ++i) {
+            out << "csopesy_core_utilization_ratio{core=\"" << i << "\",window=\"" << windowNames[w] << "\"} "
+                << windows[w].perCore[i] / 100.0 << "\n";
         }
     }
+    family("csopesy_cpu_ticks_total", "counter", "Global CPU ticks.");
+    out << "csopesy_cpu_ticks_total " << globalCpuTicks.load() << "\n";
+    return out.str();
+}
+
+// Scheduler thread only. Counts are gathered first so the segment is odd
+// (being written) for as short a time as possible.
+void Scheduler::publishStats() {
+    uint64_t now = globalCpuTicks.load();
+    auto windows = utilization_.get();
+    std::string policy = getPolicyName();
+    uint64_t ready = readyDepth();
+    uint64_t pending = admission_.pendingCount();
+    uint64_t sleeping;
+    {
+        std::lock_guard<ProfiledMutex> lock(sleepingProcessesMutex_);
+        sleeping = sleepingProcesses_.size();
+    }
+    uint64_t finished;
+    {
+        std::lock_guard<ProfiledMutex> lock(finishedProcessesMutex_);
+        finished = finishedProcesses_.size();
+    }
+
+    StatsSegmentHeader* header = statsSegment_->beginWrite();
+    StatsSnapshot& snap = header->snapshot;
+    snap.tick = now;
+    snap.wallMillis = static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    std::memset(snap.policy, 0, sizeof(snap.policy));
+    std::memcpy(snap.policy, policy.c_str(), std::min(policy.size(), sizeof(snap.policy) - 1));
+    snap.readyDepth = ready;
+    snap.memoryDepth = pending;
+    snap.sleeping = sleeping;
+    snap.finished = finished;
+    snap.active = static_cast<uint64_t>(activeProcessesCount_.load());
+    snap.dispatches = getDispatchCount();
+    snap.throttled = throttled_.load() ? 1 : 0;
+    snap.tracing = tracer_.enabled() ? 1 : 0;
+    for (size_t w = 0; w < 3; ++w) snap.utilization[w] = w < windows.size() ? windows[w].total : 0.0;
+
+    StatsCoreEntry* entries = statsCoreEntries(header);
+    uint64_t running = 0;
+    for (size_t i = 0; i < cores_.size(); ++i) {
+        auto p = cores_[i]->getRunningProcess();
+        entries[i].pid = p ? p->getPid() : -1;
+        entries[i].busy = cores_[i]->isBusy() ? 1 : 0;
+        entries[i].busyTicks = cores_[i]->getBusyTicks(now);
+        entries[i].utilization1s = windows.size() > 0 ? windows[0].perCore[i] : 0.0;
+        entries[i].utilization10s = windows.size() > 1 ? windows[1].perCore[i] : 0.0;
+        running += entries[i].busy;
+    }
+    snap.running = running;
+    statsSegment_->endWrite();
+}
+
+void Scheduler::configureDeadlines(uint64_t minTicks, uint64_t maxTicks, double share,
+    bool admissionTest, double densityBound) {
+    deadlineMin_ = minTicks;
+    deadlineMax_ = maxTicks;
+    deadlineShare_ = share;
+    deadlineAdmissionTest_ = admissionTest;
+    densityBound_ = densityBound;
+}
+
+DeadlineStats Scheduler::getDeadlineStats() const {
+    std::lock_guard<ProfiledMutex> lock(deadlineMutex_);
+    DeadlineStats st;
+    st.met = deadlinesMet_;
+    st.missed = deadlinesMissed_;
+    st.maxLateness = maxLateness_;
+    st.demoted = deadlinesDemoted_;
+    st.active = activeDeadlines_.size();
+    return st;
+}
+
+void Scheduler::setMemoryRange(int minMemPerProc, int maxMemPerProc) {
+    minMemPerProc_ = minMemPerProc;
+    maxMemPerProc_ = maxMemPerProc;
+}
+
+void Scheduler::setAdmissionMaxHeadWait(uint64_t ticks) {
+    admission_.setMaxHeadWait(ticks);
+}
+
+// Power of two in [minMemPerProc_, maxMemPerProc_]
+int Scheduler::drawMemorySize() {
+    std::vector<int> sizes;
+    for (int s = 1; s <= maxMemPerProc_ && s > 0; s <<= 1) {
+        if (s >= minMemPerProc_) sizes.push_back(s);
+    }
+    if (sizes.empty()) return minMemPerProc_;
+    std::uniform_int_distribution<size_t> dist(0, sizes.size() - 1);
+    std::lock_guard<std::mutex> lock(scheduler_gen_mutex);
+    return sizes[dist(scheduler_gen)];
+}
+
+bool Scheduler::memorySizeAllowed(int size) const {
+    if (size == 0) return true;
+    return size >= minMemPerProc_ && size <= maxMemPerProc_ && memoryManager_.fitsInShard(size);
+}
+
+AdmissionStats Scheduler::getAdmissionStats() const {
+    return admission_.getStats();
 }
 
 
 void Scheduler::notifyProcessFinished() {
 }
 
+// Called by a core when p went to sleep or used up its quantum
 void Scheduler::requeueProcess(std::shared_ptr<Process> p) {
     if (p->isSleeping()) {
-        std::lock_guard<std::mutex> lock(sleepingProcessesMutex_);
+        std::lock_guard<ProfiledMutex> lock(sleepingProcessesMutex_);
         sleepingProcesses_.push_back(p);
+        return;
+    }
+    p->markReady(globalCpuTicks.load());
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    policy_->onQuantumExpiry(std::move(p), globalCpuTicks.load());
+}
+
+void Scheduler::requeuePreempted(std::shared_ptr<Process> p) {
+    if (p->isSleeping()) {
+        std::lock_guard<ProfiledMutex> lock(sleepingProcessesMutex_);
+        sleepingProcesses_.push_back(p);
+        return;
+    }
+    p->markReady(globalCpuTicks.load());
+    enqueueReady(std::move(p));
+}
+
+void Scheduler::enqueueReady(std::shared_ptr<Process> p) {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    policy_->enqueue(std::move(p), globalCpuTicks.load());
+}
+
+void Scheduler::enqueueReadyMany(std::vector<std::shared_ptr<Process>>& processes) {
+    if (processes.empty()) return;
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    policy_->enqueueMany(processes, globalCpuTicks.load());
+}
+
+size_t Scheduler::popReadyMany(std::vector<std::shared_ptr<Process>>& out, size_t maxCount) {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    return policy_->pickMany(out, maxCount, globalCpuTicks.load());
+}
+
+bool Scheduler::popReady(std::shared_ptr<Process>& p) {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    return policy_->pickNext(p, globalCpuTicks.load());
+}
+
+bool Scheduler::popReadyFor(int core, std::shared_ptr<Process>& p) {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    return policy_->pickNextFor(core, p, globalCpuTicks.load());
+}
+
+uint64_t Scheduler::quantumFor(const Process& p) const {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    return policy_->quantumFor(p);
+}
+
+PolicySettings Scheduler::policySettings() const {
+    PolicySettings settings;
+    settings.quantum = quantumCycles_;
+    settings.adaptiveQuantum = adaptiveQuantum_.get();
+    settings.mlfqQuantums = mlfqQuantums_;
+    settings.mlfqBoostTicks = mlfqBoostTicks_;
+    settings.groups = groups_;
+    settings.topology = topologySet_ ? &topology_ : nullptr;
+    return settings;
+}
+
+// Drains the old policy into the new one under the exclusive lock, so no
+// queue operation sees a process in both or in neither
+bool Scheduler::setPolicy(const std::string& name, size_t& migrated) {
+    auto next = makeSchedulingPolicy(name, policySettings());
+    if (!next) return false;
+
+    std::unique_lock<std::shared_mutex> lock(policyMutex_);
+    std::vector<std::shared_ptr<Process>> queued;
+    migrated = policy_->drain(queued);
+    retiredLockAcquisitions_ += policy_->queueLockAcquisitions();
+    next->enqueueMany(queued, globalCpuTicks.load());
+    policy_ = std::move(next);
+    return true;
+}
+
+// Rebuilds the active policy after one of its settings changed
+void Scheduler::rebuildPolicy() {
+    size_t migrated;
+    setPolicy(getPolicyName(), migrated);
+}
+
+std::string Scheduler::getPolicyName() const {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    return policy_->name();
+}
+
+uint64_t Scheduler::getReadyQueueLockAcquisitions() const {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    return retiredLockAcquisitions_ + policy_->queueLockAcquisitions();
+}
+
+void Scheduler::configureMlfq(const std::vector<uint64_t>& quantums, uint64_t boostTicks) {
+    mlfqQuantums_ = quantums;
+    mlfqBoostTicks_ = boostTicks;
+    if (getPolicyName() == "mlfq") rebuildPolicy();
+}
+
+std::vector<MlfqLevelStats> Scheduler::getMlfqStats() const {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    auto* mlfq = dynamic_cast<MlfqPolicy*>(policy_.get());
+    if (!mlfq) return {};
+    return mlfq->getStats();
+}
+
+void Scheduler::configureAffinity(uint64_t maxWaitTicks, uint64_t warmupTicks, uint64_t warmWindow) {
+    affinityMaxWait_ = maxWaitTicks;
+    for (auto& core : cores_) core->setCacheModel(warmupTicks, warmWindow);
+}
+
+AffinityStats Scheduler::getAffinityStats() const {
+    AffinityStats st;
+    st.firstDispatches = firstDispatches_.load();
+    st.affinityHits = affinityHits_.load();
+    st.migrations = migrations_.load();
+    st.held = heldCount_.load();
+    st.crossCluster = crossCluster_.load();
+    st.crossSocket = crossSocket_.load();
+    st.penaltyTicks = penaltyTicks_.load();
+    for (const auto& core : cores_) {
+        st.coldStarts += core->getColdStarts();
+        st.warmStarts += core->getWarmStarts();
+        st.warmupTicks += core->getWarmupTicksSpent();
+    }
+    return st;
+}
+
+void Scheduler::configureAdaptiveQuantum(uint64_t minQuantum, uint64_t maxQuantum,
+    uint64_t responseTargetTicks, double maxOverhead, uint64_t adjustTicks, const std::string& logPath) {
+    adaptiveQuantum_ = std::make_unique<QuantumController>(quantumCycles_, minQuantum, maxQuantum,
+        responseTargetTicks, maxOverhead, adjustTicks, logPath);
+    if (getPolicyName() == "rr") rebuildPolicy();
+}
+
+QuantumStats Scheduler::getQuantumStats() const {
+    if (!adaptiveQuantum_) return {};
+    return adaptiveQuantum_->getStats();
+}
+
+void Scheduler::configureGroups(const std::vector<std::pair<std::string, uint32_t>>& groups) {
+    groups_ = groups;
+    groupNames_.clear();
+    for (const auto& g : groups) groupNames_.push_back(g.first);
+    if (getPolicyName() == "stride") rebuildPolicy();
+}
+
+std::vector<GroupShareStats> Scheduler::getGroupStats() const {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    auto* stride = dynamic_cast<StridePolicy*>(policy_.get());
+    if (!stride) return {};
+    return stride->getStats();
+}
+
+void Scheduler::configureBackpressure(size_t backlogHigh, size_t backlogLow, uint64_t memoryHigh,
+    uint64_t memoryLow, bool dropArrivals) {
+    backlogHigh_ = backlogHigh;
+    backlogLow_ = backlogLow;
+    memoryHigh_ = memoryHigh;
+    memoryLow_ = memoryLow;
+    dropArrivals_ = dropArrivals;
+}
+
+// Processes admitted to memory but not on a core, affinity holds included
+size_t Scheduler::readyDepth() {
+    size_t queued;
+    {
+        std::shared_lock<std::shared_mutex> lock(policyMutex_);
+        queued = policy_->size();
+    }
+    return queued + heldCount_.load();
+}
+
+// Re-evaluates the watermarks with hysteresis; returns true while throttled
+bool Scheduler::updateThrottle() {
+    if (backlogHigh_ == 0 && memoryHigh_ == 0) return false;
+    size_t backlog = readyDepth() + admission_.pendingCount();
+    uint64_t pendingBytes = admission_.pendingBytes();
+
+    if (!throttled_.load()) {
+        if ((backlogHigh_ > 0 && backlog >= backlogHigh_) ||
+            (memoryHigh_ > 0 && pendingBytes >= memoryHigh_)) {
+            throttled_ = true;
+            throttleEpisodes_++;
+        }
+    }
+    else if ((backlogHigh_ == 0 || backlog <= backlogLow_) &&
+        (memoryHigh_ == 0 || pendingBytes <= memoryLow_)) {
+        throttled_ = false;
+    }
+    return throttled_.load();
+}
+
+BackpressureStats Scheduler::getBackpressureStats() {
+    BackpressureStats st;
+    st.readyDepth = readyDepth();
+    st.memoryDepth = admission_.pendingCount();
+    st.pendingBytes = admission_.pendingBytes();
+    st.throttled = throttled_.load();
+    st.throttleEpisodes = throttleEpisodes_.load();
+    st.deferredArrivals = deferredArrivals_.load();
+    st.pausedArrivals = pausedArrivals_.load();
+    st.droppedArrivals = droppedArrivals_.load();
+    return st;
+}
+
+void Scheduler::configureTopology(const TopologyShape& shape, uint64_t clusterPenalty, uint64_t socketPenalty) {
+    if (shape.cores() != numCpus_) return;
+    topologySet_ = true;
+    topology_ = shape;
+    clusterPenalty_ = clusterPenalty;
+    socketPenalty_ = socketPenalty;
+    rebuildPolicy();
+}
+
+TopologyStats Scheduler::getTopologyStats() const {
+    std::shared_lock<std::shared_mutex> lock(policyMutex_);
+    auto* clusters = dynamic_cast<ClusterPolicy*>(policy_.get());
+    if (!clusters) return {};
+    return clusters->getStats();
+}
+
+// Busy ticks a process pays for moving between cores; 0 without a topology.
+// level is set to 1 for a move between clusters, 2 between sockets.
+uint64_t Scheduler::migrationPenalty(int fromCore, int toCore, int& level) const {
+    level = 0;
+    if (!topologySet_ || fromCore < 0 || fromCore == toCore) return 0;
+    int perSocket = topology_.clustersPerSocket * topology_.coresPerCluster;
+    if (fromCore / perSocket != toCore / perSocket) {
+        level = 2;
+        return socketPenalty_;
+    }
+    if (fromCore / topology_.coresPerCluster != toCore / topology_.coresPerCluster) {
+        level = 1;
+        return clusterPenalty_;
     }
-    else {
-        readyQueue_.push(p);
+    return 0;
+}
+
+OpcodeProfile Scheduler::getOpcodeProfile() const {
+    OpcodeProfile profile;
+    for (const auto& core : cores_) {
+        for (int op = 0; op < Process::OpcodeCount; ++op) {
+            profile.executed[op] += core->getInstructionCount(op);
+            profile.samples[op] += core->getOpcodeSamples(op);
+            profile.sampleNanos[op] += core->getOpcodeSampleNanos(op);
+        }
+        profile.loopBodyInstructions += core->getLoopBodyInstructions();
+        profile.loopIterations += core->getLoopIterations();
+    }
+    return profile;
+}
+
+uint64_t Scheduler::getDispatchCount() const {
+    return firstDispatches_.load() + affinityHits_.load() + migrations_.load();
+}
+
+double Scheduler::getMeanTurnaroundTicks() const {
+    std::lock_guard<ProfiledMutex> lock(finishedProcessesMutex_);
+    if (finishedProcesses_.empty()) return 0.0;
+    double total = 0.0;
+    for (const auto& p : finishedProcesses_) {
+        if (p->getFinishTick() >= p->getArrivalTick())
+            total += static_cast<double>(p->getFinishTick() - p->getArrivalTick());
+    }
+    return total / finishedProcesses_.size();
+}
+
+std::vector<PolicyLatency> Scheduler::getLatencyStats() const {
+    auto summarize = [](const LatencyHistogram& h) {
+        LatencySummary s;
+        s.p50 = h.percentile(0.50);
+        s.p90 = h.percentile(0.90);
+        s.p99 = h.percentile(0.99);
+        s.max = h.max();
+        return s;
+    };
+    std::lock_guard<ProfiledMutex> lock(finishedProcessesMutex_);
+    std::vector<PolicyLatency> out;
+    for (const auto& entry : latencyByPolicy_) {
+        PolicyLatency pl;
+        pl.policy = entry.first;
+        pl.finished = entry.second.finished;
+        for (int m = 0; m < LatencyMetricCount; ++m) {
+            pl.ticks[m] = summarize(entry.second.ticks[m]);
+            pl.nanos[m] = summarize(entry.second.nanos[m]);
+        }
+        out.push_back(pl);
     }
+    return out;
 }
 
 void Scheduler::startProcessGeneration() {
@@ -100,6 +665,547 @@ void Scheduler::stopProcessGeneration() {
     if (processGenThread_.joinable()) processGenThread_.join();
 }
 
+bool Scheduler::loadCorpus(const std::string& path, std::string& error) {
+    if (processGenEnabled_.load()) {
+        error = "stop the generator first";
+        return false;
+    }
+    auto corpus = std::make_shared<CorpusFile>();
+    if (!corpus->open(path, error)) return false;
+    if (corpus->programCount() == 0) {
+        error = path + " has no programs";
+        return false;
+    }
+    corpus_ = std::move(corpus);
+    corpusNext_ = 0;
+    corpusDrawn_ = 0;
+    corpusDamaged_ = 0;
+    return true;
+}
+
+bool Scheduler::clearCorpus(std::string& error) {
+    if (processGenEnabled_.load()) {
+        error = "stop the generator first";
+        return false;
+    }
+    // Processes already running corpus programs keep the mapping alive
+    corpus_.reset();
+    return true;
+}
+
+CorpusStatus Scheduler::getCorpusStatus() const {
+    CorpusStatus status;
+    if (corpus_) {
+        status.loaded = true;
+        status.path = corpus_->path();
+        status.programs = corpus_->programCount();
+        status.instructions = corpus_->instructionCount();
+    }
+    status.drawn = corpusDrawn_.load();
+    status.damaged = corpusDamaged_.load();
+    return status;
+}
+
+bool Scheduler::buildCorpus(const std::string& path, uint64_t programs, std::string& error) {
+    if (processGenEnabled_.load()) {
+        error = "stop the generator first";
+        return false;
+    }
+    CorpusWriter writer;
+    if (!writer.start(path, error)) return false;
+    Process p(0, "corpus");
+    for (uint64_t i = 0; i < programs; ++i) {
+        p.setMemorySize(drawMemorySize());
+        p.genRandInst(minInstructions_, maxInstructions_, memOpRatio_);
+        writer.add(p);
+    }
+    return writer.finish(error);
+}
+
+bool Scheduler::startRecording(const std::string& path) {
+    if (!recorder_.start(path, globalCpuTicks.load())) return false;
+    recording_ = true;
+    return true;
+}
+
+uint64_t Scheduler::stopRecording() {
+    recording_ = false;
+    return recorder_.stop();
+}
+
+bool Scheduler::startReplay(const std::string& path, bool fast, std::string& error) {
+    if (replayEnabled_.load()) {
+        error = "a replay is already running";
+        return false;
+    }
+    if (replayThread_.joinable()) replayThread_.join();   // an earlier replay that ran out
+
+    auto reader = std::make_unique<WorkloadReader>();
+    if (!reader->open(path, error)) return false;
+    replayReader_ = std::move(reader);
+    replayFast_ = fast;
+    replayTotal_ = replayReader_->processCount();
+    replaySubmitted_ = 0;
+    replayResized_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(replayMutex_);
+        replayError_.clear();
+    }
+    replayEnabled_ = true;
+    replayThread_ = std::thread(&Scheduler::replayLoop, this);
+    return true;
+}
+
+void Scheduler::stopReplay() {
+    replayEnabled_ = false;
+    if (replayThread_.joinable()) replayThread_.join();
+}
+
+ReplayProgress Scheduler::getReplayProgress() const {
+    ReplayProgress progress;
+    progress.active = replayEnabled_.load();
+    progress.fast = replayFast_;
+    progress.submitted = replaySubmitted_.load();
+    progress.total = replayTotal_;
+    progress.resized = replayResized_.load();
+    std::lock_guard<std::mutex> lock(replayMutex_);
+    progress.error = replayError_;
+    return progress;
+}
+
+// Fast replay: when nothing can make progress before until, nobody is
+// waiting on the ticks in between, so the clock jumps ahead to the next
+// arrival or to the earliest wake-up, whichever comes first
+void Scheduler::skipIdleTicks(uint64_t until) {
+    if (getCoresUsed() > 0 || readyDepth() > 0 || admission_.pendingCount() > 0) return;
+    uint64_t target = until;
+    {
+        std::lock_guard<ProfiledMutex> lock(sleepingProcessesMutex_);
+        for (const auto& p : sleepingProcesses_) {
+            if (p->getSleepTargetTick() < target) target = p->getSleepTargetTick();
+        }
+    }
+    uint64_t now = globalCpuTicks.load();
+    while (now < target && !globalCpuTicks.compare_exchange_weak(now, target)) {}
+}
+
+// Submits the recorded processes when their arrival ticks come up. Like the
+// generator it wakes up periodically, and everything that has come due in
+// the meantime is submitted as one batch.
+void Scheduler::replayLoop() {
+    uint64_t base = globalCpuTicks.load();
+    WorkloadEntry entry;
+    bool pending = replayReader_->next(entry);
+    while (replayEnabled_.load() && pending) {
+        uint64_t now = globalCpuTicks.load();
+        if (now < base + entry.arrivalTick) {
+            if (replayFast_) skipIdleTicks(base + entry.arrivalTick);
+            // Short naps keep replayed arrivals within a few ticks of the recording
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
+
+        std::vector<std::shared_ptr<Process>> batch;
+        while (pending && base + entry.arrivalTick <= now) {
+            auto proc = std::make_shared<Process>(getNextProcessId(), entry.name);
+            proc->setGroup(entry.group);
+            if (memorySizeAllowed(entry.memorySize)) {
+                proc->setMemorySize(entry.memorySize);
+            }
+            else {
+                // Recorded under a different memory config
+                proc->setMemorySize(drawMemorySize());
+                replayResized_++;
+            }
+            proc->setRelativeDeadline(entry.relativeDeadline);
+            proc->loadProgram(std::move(entry.program));
+            batch.push_back(proc);
+            pending = replayReader_->next(entry);
+        }
+        submitBatch(batch);
+        replaySubmitted_ += batch.size();
+    }
+
+    if (!replayReader_->error().empty()) {
+        std::lock_guard<std::mutex> lock(replayMutex_);
+        replayError_ = replayReader_->error();
+    }
+    replayEnabled_ = false;
+}
+
+void Scheduler::pauseScheduling() {
+    pauseRequested_ = true;
+    while (running_.load() && !paused_.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (const auto& core : cores_) {
+        if (core->isBusy()) core->preempt();
+    }
+    while (getCoresUsed() > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void Scheduler::resumeScheduling() {
+    pauseRequested_ = false;
+    // Wait for the loop to leave the park, so a following pause cannot see
+    // a stale paused_
+    while (running_.load() && paused_.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+namespace {
+const char CheckpointMagic[8] = { 'C', 'S', 'C', 'H', 'K', 'P', 'T', '1' };
+const uint32_t CheckpointVersion = 3;
+
+uint64_t steadyNanosNow() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// The code section of a checkpoint. add() only notes where each program
+// goes, so the scheduler can resume before write() copies the code out with
+// its names moved into one table.
+class CheckpointCode {
+public:
+    // Returns the index of p's first instruction in the section
+    uint64_t add(const Process& p) {
+        const PackedInstruction* code = p.getCode();
+        size_t count = p.getTotalInstructions();
+        auto stored = stored_.find(code);
+        if (stored != stored_.end() && programs_[stored->second].count == count) {
+            return programs_[stored->second].first;
+        }
+        const auto& image = p.getProgramImage();
+        auto remap = remaps_.find(image.get());
+        if (remap == remaps_.end()) {
+            remap = remaps_.emplace(image.get(), std::vector<uint32_t>()).first;
+            if (image) {
+                for (const auto& name : image->names) remap->second.push_back(names_.intern(name));
+            }
+        }
+        stored_[code] = programs_.size();
+        programs_.push_back({ image, code, count, instructions_, &remap->second });
+        instructions_ += count;
+        return instructions_ - count;
+    }
+
+    uint64_t instructionCount() const { return instructions_; }
+    const std::vector<std::string>& names() const { return names_.names; }
+
+    void write(std::ostream& out) {
+        std::vector<PackedInstruction> buffer;
+        for (const auto& program : programs_) {
+            buffer.assign(program.code, program.code + program.count);
+            for (auto& ins : buffer) {
+                for (size_t a = 0; a < PackedWriter::storedOperands(ins); ++a) {
+                    if (!operandIsName(ins.opcode, a, ins.args[a])) continue;
+                    ins.args[a] = (*program.remap)[ins.args[a] & ~OperandVariable] | (ins.args[a] & OperandVariable);
+                }
+            }
+            out.write(reinterpret_cast<const char*>(buffer.data()),
+                static_cast<std::streamsize>(buffer.size() * sizeof(PackedInstruction)));
+        }
+    }
+
+private:
+    struct Program {
+        std::shared_ptr<const ProgramImage> image;  // keeps code alive until written
+        const PackedInstruction* code;
+        size_t count;
+        uint64_t first;
+        const std::vector<uint32_t>* remap;         // image name index -> section index
+    };
+    NameTable names_;
+    std::vector<Program> programs_;
+    std::unordered_map<const PackedInstruction*, size_t> stored_;
+    std::unordered_map<const ProgramImage*, std::vector<uint32_t>> remaps_;
+    uint64_t instructions_ = 0;
+};
+}
+
+// Everything is gathered and encoded while the scheduler is paused, so every
+// process is in exactly one place and none is changing. Programs never change
+// once loaded, so their code is copied out after the scheduler resumes.
+bool Scheduler::writeCheckpoint(const std::string& path, CheckpointSummary& summary, std::string& error) {
+    if (processGenEnabled_.load() || replayEnabled_.load()) {
+        error = "stop the generator and any replay first";
+        return false;
+    }
+    // Written next to the target and renamed over it: the target may be the
+    // checkpoint restored processes are running from
+    std::string temp = path + ".tmp";
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "cannot open " + temp + " for writing";
+        return false;
+    }
+
+    pauseScheduling();
+    CheckpointFileHeader header{};
+    std::memcpy(header.magic, CheckpointMagic, sizeof(header.magic));
+    header.version = CheckpointVersion;
+    header.tick = globalCpuTicks.load();
+    header.steadyNanos = steadyNanosNow();
+
+    // Held processes were popped ahead of everything still queued
+    std::vector<std::shared_ptr<Process>> ready;
+    for (const auto& hold : holds_) {
+        if (hold.process) ready.push_back(hold.process);
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(policyMutex_);
+        std::vector<std::shared_ptr<Process>> queued;
+        policy_->drain(queued);
+        ready.insert(ready.end(), queued.begin(), queued.end());
+        policy_->enqueueMany(queued, header.tick);
+        summary.policy = policy_->name();
+    }
+    std::vector<std::shared_ptr<Process>> sleeping = getSleepingProcesses();
+    std::vector<std::pair<std::shared_ptr<Process>, uint64_t>> pending;
+    admission_.getPending(pending);
+    std::vector<std::shared_ptr<Process>> finished = getFinishedProcesses();
+    std::vector<MemoryBlock> blocks;
+    std::vector<char> contents;
+    memoryManager_.exportLayout(blocks, contents);
+
+    PackedWriter body;
+    body.putString(summary.policy);
+    body.putVarint(static_cast<uint64_t>(nextPid_.load()));
+    body.putVarint(static_cast<uint64_t>(memoryManager_.getMaxMemory()));
+    body.putVarint(static_cast<uint64_t>(memoryManager_.getMemPerFrame()));
+    // The name table goes in front of the records but is complete only
+    // after them
+    CheckpointCode code;
+    PackedWriter records;
+    auto put = [&records, &code](const Process& p, CheckpointLocation location) {
+        records.putVarint(static_cast<uint64_t>(p.getPid()));
+        records.putVarint(static_cast<uint64_t>(location));
+        records.putVarint(code.add(p));
+        records.putVarint(p.getTotalInstructions());
+    };
+    for (const auto& p : ready) {
+        put(*p, CheckpointLocation::Ready);
+        p->writeState(records);
+    }
+    for (const auto& p : sleeping) {
+        put(*p, CheckpointLocation::Sleeping);
+        p->writeState(records);
+    }
+    for (const auto& entry : pending) {
+        put(*entry.first, CheckpointLocation::MemoryWait);
+        records.putVarint(entry.second);
+        entry.first->writeState(records);
+    }
+    for (const auto& p : finished) {
+        put(*p, CheckpointLocation::Finished);
+        p->writeState(records);
+    }
+    records.putVarint(blocks.size());
+    for (const auto& b : blocks) {
+        records.putVarint(static_cast<uint64_t>(b.start));
+        records.putVarint(static_cast<uint64_t>(b.end));
+        records.putVarint(static_cast<uint64_t>(b.pid));
+    }
+    records.putVarint(contents.size());
+    records.putBytes(contents.data(), contents.size());
+    resumeScheduling();
+
+    body.putVarint(code.names().size());
+    for (const auto& name : code.names()) body.putString(name);
+    header.processes = ready.size() + sleeping.size() + pending.size() + finished.size();
+    header.instructions = code.instructionCount();
+    header.codeOffset = sizeof(header);
+    header.bodyOffset = header.codeOffset + header.instructions * sizeof(PackedInstruction);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    code.write(out);
+    out.write(body.buffer().data(), static_cast<std::streamsize>(body.buffer().size()));
+    out.write(records.buffer().data(), static_cast<std::streamsize>(records.buffer().size()));
+    out.close();
+    if (!out || !replaceFile(temp, path)) {
+        std::remove(temp.c_str());
+        error = "cannot write " + path;
+        return false;
+    }
+
+    summary.tick = header.tick;
+    summary.ready = ready.size();
+    summary.sleeping = sleeping.size();
+    summary.memoryWait = pending.size();
+    summary.finished = finished.size();
+    summary.allocatedBlocks = blocks.size();
+    summary.bytes = header.bodyOffset + body.buffer().size() + records.buffer().size();
+    return true;
+}
+
+// The file is mapped rather than read, and decoded in full before anything
+// in the scheduler changes, so a damaged file leaves the emulator as it was.
+// Only the records are decoded; programs are checked and then run from the
+// mapping.
+bool Scheduler::restoreCheckpoint(const std::string& path, CheckpointSummary& summary, std::string& error) {
+    if (processGenEnabled_.load() || replayEnabled_.load()) {
+        error = "stop the generator and any replay first";
+        return false;
+    }
+    if (activeProcessesCount_.load() > 0 || !getFinishedProcesses().empty()) {
+        error = "processes already exist; restore right after initialize";
+        return false;
+    }
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(path, error)) return false;
+    CheckpointFileHeader header{};
+    size_t size = file->size();
+    if (size < sizeof(header)) {
+        error = path + " is not a checkpoint";
+        return false;
+    }
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, CheckpointMagic, sizeof(header.magic)) != 0) {
+        error = path + " is not a checkpoint";
+        return false;
+    }
+    if (header.version != CheckpointVersion) {
+        error = path + " has unsupported checkpoint version " + std::to_string(header.version);
+        return false;
+    }
+    if (header.processes > size) {
+        error = path + " is damaged: header claims " + std::to_string(header.processes) + " processes";
+        return false;
+    }
+    // The code must lie inside the file, aligned for direct access
+    if (header.codeOffset < sizeof(header) || header.codeOffset % alignof(PackedInstruction) != 0
+        || header.codeOffset > size
+        || header.instructions > (size - header.codeOffset) / sizeof(PackedInstruction)
+        || header.bodyOffset != header.codeOffset + header.instructions * sizeof(PackedInstruction)) {
+        error = path + " is damaged: its sections do not fit the file";
+        return false;
+    }
+    const PackedInstruction* code = reinterpret_cast<const PackedInstruction*>(file->data() + header.codeOffset);
+
+    PackedReader in(file->data() + header.bodyOffset, size - header.bodyOffset);
+    auto damaged = [&]() {
+        error = "damaged checkpoint at byte " + std::to_string(header.bodyOffset + in.position());
+        return false;
+    };
+    uint64_t nextPid, maxMemory, memPerFrame;
+    if (!in.getString(summary.policy) || !in.getVarint(nextPid) || !in.getVarint(maxMemory)
+        || !in.getVarint(memPerFrame)) {
+        return damaged();
+    }
+    if (maxMemory != static_cast<uint64_t>(memoryManager_.getMaxMemory())
+        || memPerFrame != static_cast<uint64_t>(memoryManager_.getMemPerFrame())) {
+        error = "checkpoint was taken with max-overall-mem " + std::to_string(maxMemory) + " and mem-per-frame "
+            + std::to_string(memPerFrame) + "; this configuration differs";
+        return false;
+    }
+    if (!isSchedulingPolicyName(summary.policy)) {
+        error = "checkpoint uses unknown policy '" + summary.policy + "'";
+        return false;
+    }
+    auto image = std::make_shared<ProgramImage>();
+    uint64_t names;
+    if (!in.getVarint(names) || names > size) return damaged();
+    image->names.resize(static_cast<size_t>(names));
+    for (auto& name : image->names) {
+        if (!in.getString(name)) return damaged();
+    }
+    image->file = file;
+    std::shared_ptr<const ProgramImage> shared = std::move(image);
+
+    uint64_t now = globalCpuTicks.load();
+    uint64_t tickOffset = now > header.tick ? now - header.tick : 0;
+    std::vector<std::shared_ptr<Process>> ready, sleeping, finished;
+    std::vector<std::pair<std::shared_ptr<Process>, uint64_t>> pending;
+    ready.reserve(static_cast<size_t>(header.processes));
+    for (uint64_t i = 0; i < header.processes; ++i) {
+        uint64_t pid, location, first, count, enqueueTick = 0;
+        if (!in.getVarint(pid) || !in.getVarint(location) || pid > INT32_MAX
+            || location > static_cast<uint64_t>(CheckpointLocation::Finished)) {
+            return damaged();
+        }
+        if (!in.getVarint(first) || !in.getVarint(count) || first > header.instructions
+            || count > header.instructions - first
+            || !bytecodeFits(code + first, static_cast<size_t>(count), shared->names.size())) {
+            return damaged();
+        }
+        if (location == static_cast<uint64_t>(CheckpointLocation::MemoryWait) && !in.getVarint(enqueueTick)) {
+            return damaged();
+        }
+        auto p = std::make_shared<Process>(static_cast<int>(pid), "");
+        p->loadProgram(shared, code + first, static_cast<size_t>(count));
+        if (!p->readState(in, tickOffset, header.steadyNanos)) return damaged();
+        switch (static_cast<CheckpointLocation>(location)) {
+        case CheckpointLocation::Ready: ready.push_back(std::move(p)); break;
+        case CheckpointLocation::Sleeping: sleeping.push_back(std::move(p)); break;
+        case CheckpointLocation::MemoryWait: pending.emplace_back(std::move(p), enqueueTick + tickOffset); break;
+        case CheckpointLocation::Finished: finished.push_back(std::move(p)); break;
+        }
+    }
+    uint64_t blockCount, contentSize;
+    if (!in.getVarint(blockCount) || blockCount > header.processes) return damaged();
+    std::vector<MemoryBlock> blocks(static_cast<size_t>(blockCount));
+    for (auto& b : blocks) {
+        uint64_t start, end, pid;
+        if (!in.getVarint(start) || !in.getVarint(end) || !in.getVarint(pid) || end > maxMemory || pid > INT32_MAX) {
+            return damaged();
+        }
+        b = { static_cast<int>(start), static_cast<int>(end), static_cast<int>(pid) };
+    }
+    const char* contents = nullptr;
+    if (!in.getVarint(contentSize) || !in.getView(contents, static_cast<size_t>(contentSize))) return damaged();
+
+    pauseScheduling();
+    if (!memoryManager_.restoreLayout(blocks, contents, static_cast<size_t>(contentSize))) {
+        resumeScheduling();
+        error = "the saved memory layout does not fit this memory";
+        return false;
+    }
+    size_t migrated;
+    setPolicy(summary.policy, migrated);
+    while (now < header.tick && !globalCpuTicks.compare_exchange_weak(now, header.tick)) {}
+    int savedPid = static_cast<int>(nextPid);
+    int current = nextPid_.load();
+    while (current < savedPid && !nextPid_.compare_exchange_weak(current, savedPid)) {}
+
+    {
+        std::lock_guard<ProfiledMutex> lock(deadlineMutex_);
+        auto track = [this](const std::shared_ptr<Process>& p) {
+            if (p->isInMemory()) p->attachMemory(&memoryManager_);
+            if (p->hasDeadline()) {
+                p->snapshotRemainingWork();
+                activeDeadlines_.push_back(p);
+            }
+        };
+        for (const auto& p : ready) track(p);
+        for (const auto& p : sleeping) track(p);
+        for (const auto& entry : pending) track(entry.first);
+    }
+    activeProcessesCount_ += static_cast<int>(ready.size() + sleeping.size() + pending.size());
+    {
+        std::lock_guard<ProfiledMutex> lock(sleepingProcessesMutex_);
+        sleepingProcesses_.insert(sleepingProcesses_.end(), sleeping.begin(), sleeping.end());
+    }
+    for (auto& entry : pending) admission_.restorePending(entry.first, entry.second);
+    {
+        std::lock_guard<ProfiledMutex> lock(finishedProcessesMutex_);
+        for (const auto& p : finished) finishedPIDs_.insert(p->getPid());
+        finishedProcesses_.insert(finishedProcesses_.end(), finished.begin(), finished.end());
+    }
+    summary.ready = ready.size();
+    enqueueReadyMany(ready);
+    resumeScheduling();
+
+    summary.tick = header.tick;
+    summary.sleeping = sleeping.size();
+    summary.memoryWait = pending.size();
+    summary.finished = finished.size();
+    summary.allocatedBlocks = blocks.size();
+    summary.bytes = size;
+    return true;
+}
+
 void Scheduler::waitUntilAllDone() {
     while (activeProcessesCount_.load() > 0) {
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
@@ -124,18 +1230,21 @@ std::vector<std::shared_ptr<Process>> Scheduler::getRunningProcesses() const {
 }
 
 std::vector<std::shared_ptr<Process>> Scheduler::getFinishedProcesses() const {
-    std::lock_guard<std::mutex> lock(finishedProcessesMutex_);
+    std::lock_guard<ProfiledMutex> lock(finishedProcessesMutex_);
     return finishedProcesses_;
 }
 
 std::vector<std::shared_ptr<Process>> Scheduler::getSleepingProcesses() const {
-    std::lock_guard<std::mutex> lock(sleepingProcessesMutex_);
+    std::lock_guard<ProfiledMutex> lock(sleepingProcessesMutex_);
     return sleepingProcesses_;
 }
 
 double Scheduler::getCpuUtilization() const {
     if (numCpus_ == 0) return 0.0;
 
+    auto windows = utilization_.get();
+    if (!windows.empty() && windows[0].coveredSeconds >= 1.0) return windows[0].total;
+
     int busyCores = getCoresUsed();
     double utilization = static_cast<double>(busyCores) / numCpus_ * 100.0;
 
@@ -166,28 +1275,74 @@ Core* Scheduler::getCore(int index) const {
 }
 
 void Scheduler::addFinishedProcess(std::shared_ptr<Process> p) {
-    std::lock_guard<std::mutex> lock(finishedProcessesMutex_);
+    std::lock_guard<ProfiledMutex> lock(finishedProcessesMutex_);
     if (finishedPIDs_.find(p->getPid()) == finishedPIDs_.end()) {
-        p->setFinishTime(time(nullptr));
-        memoryManager_.deallocate(p->getPid());
-        finishedProcesses_.push_back(p);
-        finishedPIDs_.insert(p->getPid());
-        activeProcessesCount_--;
+        markFinished(p);
     }
 }
 
 
 
+// Caller holds finishedProcessesMutex_
+void Scheduler::markFinished(const std::shared_ptr<Process>& p) {
+    p->setFinishTime(time(nullptr));
+    p->markFinished(globalCpuTicks.load());
+    memoryManager_.deallocate(p->getPid());
+    p->setInMemory(false);
+    std::string policy;
+    {
+        std::shared_lock<std::shared_mutex> lock(policyMutex_);
+        policy_->onFinish(*p);
+        policy = policy_->name();
+    }
+    LatencyHistograms& latency = latencyByPolicy_[policy];
+    const Process::Timing timings[LatencyMetricCount] = {
+        p->getResponseTime(), p->getTotalWait(), p->getTotalRun(), p->getTurnaroundTime() };
+    for (int m = 0; m < LatencyMetricCount; ++m) {
+        latency.ticks[m].record(timings[m].ticks);
+        latency.nanos[m].record(timings[m].nanos);
+    }
+    latency.finished++;
+    if (p->hasDeadline()) {
+        std::lock_guard<ProfiledMutex> lock(deadlineMutex_);
+        uint64_t finish = p->getFinishTick();
+        if (finish > p->getDeadline()) {
+            deadlinesMissed_++;
+            if (finish - p->getDeadline() > maxLateness_) maxLateness_ = finish - p->getDeadline();
+        }
+        else {
+            deadlinesMet_++;
+        }
+        activeDeadlines_.erase(std::remove(activeDeadlines_.begin(), activeDeadlines_.end(), p),
+            activeDeadlines_.end());
+    }
+    finishedProcesses_.push_back(p);
+    finishedPIDs_.insert(p->getPid());
+    activeProcessesCount_--;
+}
+
 void Scheduler::schedulerLoop() {
     while (running_.load()) {
+        if (pauseRequested_.load()) {
+            paused_ = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        paused_ = false;
+
         {
-            std::lock_guard<std::mutex> lock(sleepingProcessesMutex_);
+            std::lock_guard<ProfiledMutex> lock(sleepingProcessesMutex_);
             auto now = globalCpuTicks.load();
             auto it = sleepingProcesses_.begin();
             while (it != sleepingProcesses_.end()) {
                 if ((*it)->isSleeping() && now >= (*it)->getSleepTargetTick()) {
                     (*it)->setIsSleeping(false);
-                    readyQueue_.push(*it);
+                    (*it)->markReady(now);
+                    if (tracer_.enabled()) {
+                        tracer_.record(tracer_.schedulerRing(), TraceEventType::Wake, (*it)->getPid(), -1, now);
+                    }
+                    std::shared_lock<std::shared_mutex> policyLock(policyMutex_);
+                    policy_->onWake(*it, now);
                     it = sleepingProcesses_.erase(it);
                 }
                 else {
@@ -196,53 +1351,52 @@ void Scheduler::schedulerLoop() {
             }
         }
 
-        while (!memoryPendingQueue.empty()) {
-            std::shared_ptr<Process> p = memoryPendingQueue.front();
-            if (memoryManager_.allocate(p->getPid())) {
-                readyQueue_.push(p);
-                memoryPendingQueue.pop();
-            }
-            else {
-                break;
-            }
+        {
+            std::shared_lock<std::shared_mutex> lock(policyMutex_);
+            policy_->onTick(globalCpuTicks.load());
         }
 
-        for (size_t i = 0; i < cores_.size(); ++i) {
-            int index = (nextCoreIndex_ + i) % cores_.size();
-            auto& core = cores_[index];
+        compactMemory();
+        sampleUtilization();
+        if (deadlineAdmissionTest_) sampleCoreRate();
 
-            if (!core->isBusy()) {
-                std::shared_ptr<Process> p;
-                if (readyQueue_.try_pop(p)) {
-                    uint64_t quantum = (schedulerType_ == "rr") ? quantumCycles_ : UINT64_MAX;
-                    if (!core->tryAssign(p, quantum)) {
-                        std::cout << "[Scheduler] Core-" << index << " failed to assign process " << p->getName() << ". Requeuing.\n";
-                        requeueProcess(p);
-                    }
-                    else {
-                        nextCoreIndex_ = (index + 1) % cores_.size();
-                    }
+        {
+            std::vector<std::shared_ptr<Process>> admitted;
+            uint64_t now = globalCpuTicks.load();
+            admission_.admit(now, admitted);
+            if (tracer_.enabled()) {
+                for (const auto& p : admitted) {
+                    uint64_t waited = now - p->getArrivalTick();
+                    tracer_.record(tracer_.schedulerRing(), TraceEventType::Admit, p->getPid(), -1, now,
+                        static_cast<uint32_t>(waited > UINT32_MAX ? UINT32_MAX : waited));
                 }
             }
+            enqueueReadyMany(admitted);
+        }
+
+        if (adaptiveQuantum_) {
+            std::shared_lock<std::shared_mutex> lock(policyMutex_);
+            if (policy_->name() == "rr") {
+                adaptiveQuantum_->update(globalCpuTicks.load(), policy_->size(), numCpus_);
+            }
         }
 
+        dispatchReady();
+
         {
-            std::lock_guard<std::mutex> lock(finishedProcessesMutex_);
+            std::lock_guard<ProfiledMutex> lock(finishedProcessesMutex_);
             for (auto& core : cores_) {
                 auto p = core->getRunningProcess();
                 if (p && p->isFinished()) {
-                    int pid = p->getPid();
-                    if (finishedPIDs_.find(pid) == finishedPIDs_.end()) {
-                        p->setFinishTime(time(nullptr));
-                        memoryManager_.deallocate(pid);
-                        finishedProcesses_.push_back(p);
-                        finishedPIDs_.insert(pid);
-                        activeProcessesCount_--;
+                    if (finishedPIDs_.find(p->getPid()) == finishedPIDs_.end()) {
+                        markFinished(p);
                     }
                 }
             }
         }
 
+        if (statsSegment_) publishStats();
+
         uint64_t now = globalCpuTicks.load();
         if ((now - lastQuantumSnapshot_) >= quantumCycles_) {
             memoryManager_.dumpSnapshot(quantumIndex_++);
@@ -253,16 +1407,226 @@ void Scheduler::schedulerLoop() {
     }
 }
 
+// Free core that is not reserved for a held process, scanning round-robin
+// from nextCoreIndex_; -1 if none
+int Scheduler::findFreeCore() const {
+    for (size_t i = 0; i < cores_.size(); ++i) {
+        int index = static_cast<int>((nextCoreIndex_ + i) % cores_.size());
+        if (!cores_[index]->isBusy() && !holds_[index].process) return index;
+    }
+    return -1;
+}
+
+bool Scheduler::assignToCore(int index, std::shared_ptr<Process> p) {
+    int lastCore = p->getLastCoreId();
+    uint64_t quantum = quantumFor(*p);
+    int level;
+    uint64_t penalty = migrationPenalty(lastCore, index, level);
+    auto started = std::chrono::steady_clock::now();
+    bool assigned = cores_[index]->tryAssign(p, quantum, penalty);
+    if (adaptiveQuantum_) {
+        adaptiveQuantum_->recordDispatch(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - started).count()));
+    }
+    if (!assigned) {
+        std::cout << "[Scheduler] Core-" << index << " failed to assign process " << p->getName() << ". Requeuing.\n";
+        enqueueReady(p);
+        return false;
+    }
+    if (level == 1) crossCluster_++;
+    if (level == 2) crossSocket_++;
+    penaltyTicks_ += penalty;
+    if (lastCore < 0) firstDispatches_++;
+    else if (lastCore == index) affinityHits_++;
+    else migrations_++;
+    nextCoreIndex_ = (index + 1) % cores_.size();
+    return true;
+}
+
+// Places ready processes on free cores, preferring the core each one last
+// ran on. A process whose core is busy but still warm for it is held for
+// that core (one per core) and migrates to any free core once it has waited affinityMaxWait_ ticks.
+void Scheduler::dispatchReady() {
+    bool perCore;
+    {
+        std::shared_lock<std::shared_mutex> lock(policyMutex_);
+        perCore = policy_->perCoreQueues();
+    }
+    if (perCore) {
+        dispatchTopology();
+        return;
+    }
+    uint64_t now = globalCpuTicks.load();
+
+    for (size_t i = 0; i < holds_.size(); ++i) {
+        AffinityHold& hold = holds_[i];
+        if (!hold.process) continue;
+        if (!cores_[i]->isBusy()) {
+            auto p = std::move(hold.process);
+            hold.process = nullptr;
+            heldCount_--;
+            assignToCore(static_cast<int>(i), p);
+        }
+        else if (now - hold.since >= affinityMaxWait_) {
+            int index = findFreeCore();
+            if (index < 0) continue;
+            auto p = std::move(hold.process);
+            hold.process = nullptr;
+            heldCount_--;
+            assignToCore(index, p);
+        }
+    }
+
+    // One pop fills every free core; held processes leave their core free,
+    // so go round again until the cores or the queue run out
+    std::vector<std::shared_ptr<Process>> batch;
+    for (size_t round = 0; round <= cores_.size(); ++round) {
+        size_t freeCores = countFreeCores();
+        if (freeCores == 0) break;
+        batch.clear();
+        if (popReadyMany(batch, freeCores) == 0) break;
+        for (auto& p : batch) placeReady(p, now);
+    }
+}
+
+// Each free core takes work from its own cluster's queue first; stealing is
+// left to the policy. Stops as soon as every queue is empty.
+void Scheduler::dispatchTopology() {
+    // Holds left over from a policy without per-core queues go back to the
+    // queues, which keep each process near its last core on their own.
+    // Queued before the count drops, so readyDepth never misses one.
+    if (heldCount_.load() > 0) {
+        std::vector<std::shared_ptr<Process>> released;
+        for (auto& hold : holds_) {
+            if (hold.process) released.push_back(std::move(hold.process));
+            hold.process = nullptr;
+        }
+        enqueueReadyMany(released);
+        heldCount_ -= released.size();
+    }
+    for (int index = 0; index < numCpus_; ++index) {
+        if (cores_[index]->isBusy()) continue;
+        std::shared_ptr<Process> p;
+        if (!popReadyFor(index, p)) return;
+        assignToCore(index, p);
+    }
+}
+
+size_t Scheduler::countFreeCores() const {
+    size_t count = 0;
+    for (size_t i = 0; i < cores_.size(); ++i) {
+        if (!cores_[i]->isBusy() && !holds_[i].process) count++;
+    }
+    return count;
+}
+
+void Scheduler::placeReady(std::shared_ptr<Process> p, uint64_t now) {
+    int preferred = p->getLastCoreId();
+    if (preferred >= 0 && preferred < numCpus_) {
+        if (!cores_[preferred]->isBusy() && !holds_[preferred].process) {
+            assignToCore(preferred, p);
+            return;
+        }
+        // Waiting only pays off while the process is still warm there
+        if (affinityMaxWait_ > 0 && !holds_[preferred].process &&
+            cores_[preferred]->isWarmFor(*p)) {
+            holds_[preferred].process = p;
+            holds_[preferred].since = now;
+            heldCount_++;
+            return;
+        }
+    }
+    int index = findFreeCore();
+    if (index >= 0) assignToCore(index, p);
+    else enqueueReady(p);
+}
+
+// Runs one bounded compaction step when a waiting process would fit in the
+// free memory of one shard but not in any single hole. Free memory split
+// across shards cannot be joined, so then there is nothing to do.
+void Scheduler::compactMemory() {
+    if (compactionStepBytes_ <= 0) return;
+
+    int need = admission_.smallestPendingSize();
+    if (need == 0 || memoryManager_.largestFreeBlock() >= need
+        || memoryManager_.largestCompactableBlock() < need) {
+        return;
+    }
+
+    // Processes on a core are never moved
+    std::unordered_set<int> onCore;
+    for (const auto& core : cores_) {
+        auto p = core->getRunningProcess();
+        if (p) onCore.insert(p->getPid());
+    }
+    memoryManager_.compactStep(compactionStepBytes_, [&onCore](int pid) {
+        return onCore.count(pid) > 0;
+        });
+}
+
 void Scheduler::processGeneratorLoop() {
     while (processGenEnabled_.load()) {
         uint64_t now = globalCpuTicks.load();
         if (now >= lastProcessGenTick_.load() + batchProcessFreq_) {
-            int pid = getNextProcessId();
-            std::string name = "p" + std::to_string(pid);
-            auto proc = std::make_shared<Process>(pid, name);
-            proc->genRandInst(minInstructions_, maxInstructions_);
-            submit(proc);
+            uint64_t owed = (now - lastProcessGenTick_.load()) / batchProcessFreq_;
             lastProcessGenTick_ = now;
+            if (updateThrottle()) {
+                // Only what this pass would have created; the rest of owed
+                // is skipped unthrottled too, so deferring it could never drain
+                uint64_t arrivals = planArrivals(owed, 0, batchSubmitMax_).fresh;
+                if (dropArrivals_) droppedArrivals_ += arrivals;
+                else {
+                    deferredArrivals_ += arrivals;
+                    pausedArrivals_ += arrivals;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+
+            // Catch up on the processes owed since the last pass and on
+            // deferred ones, each bounded by batchSubmitMax_
+            ArrivalPlan plan = planArrivals(owed, deferredArrivals_.load(), batchSubmitMax_);
+            deferredArrivals_ -= plan.resumed;
+            size_t count = plan.fresh + plan.resumed;
+
+            std::vector<std::shared_ptr<Process>> batch;
+            batch.reserve(count);
+            for (size_t i = 0; i < count; ++i) {
+                int pid = getNextProcessId();
+                std::string name = "p" + std::to_string(pid);
+                auto proc = std::make_shared<Process>(pid, name);
+                if (!groupNames_.empty()) {
+                    proc->setGroup(groupNames_[nextGroup_]);
+                    nextGroup_ = (nextGroup_ + 1) % groupNames_.size();
+                }
+                const PackedInstruction* code;
+                size_t codeSize;
+                int memorySize;
+                // A size that does not suit this config counts as damaged,
+                // like a bad table entry; it could never be admitted
+                if (corpus_ && corpus_->program(corpusNext_, code, codeSize, memorySize)
+                    && memorySizeAllowed(memorySize)) {
+                    proc->setMemorySize(memorySize > 0 ? memorySize : drawMemorySize());
+                    proc->loadProgram(corpus_->image(), code, codeSize);
+                    corpusDrawn_++;
+                }
+                else {
+                    if (corpus_) corpusDamaged_++;
+                    proc->setMemorySize(drawMemorySize());
+                    proc->genRandInst(minInstructions_, maxInstructions_, memOpRatio_);
+                }
+                if (corpus_) corpusNext_ = (corpusNext_ + 1) % corpus_->programCount();
+                if (deadlineMax_ > 0) {
+                    std::uniform_real_distribution<double> coin(0.0, 1.0);
+                    std::lock_guard<std::mutex> lock(scheduler_gen_mutex);
+                    if (coin(scheduler_gen) < deadlineShare_) {
+                        std::uniform_int_distribution<uint64_t> dist(deadlineMin_, deadlineMax_);
+                        proc->setRelativeDeadline(dist(scheduler_gen));
+                    }
+                }
+                batch.push_back(proc);
+            }
+            submitBatch(batch);
         }
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
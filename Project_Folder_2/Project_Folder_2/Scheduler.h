@@ -6,14 +6,125 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <shared_mutex>
+#include <map>
 #include <unordered_set> 
 #include <queue> 
 
 #include "Core.h"
 #include "Process.h"
 #include "ThreadedQueue.h"
+#include "ProfiledMutex.h"
 #include "GlobalState.h"
 #include "MemoryManager.h" 
+#include "AdmissionController.h"
+#include "SchedulingPolicy.h"
+#include "UtilizationTracker.h"
+#include "EventTracer.h"
+#include "LatencyHistogram.h"
+#include "StatsSegment.h"
+#include "MetricsExporter.h"
+#include "WorkloadFile.h"
+#include "Checkpoint.h"
+#include "CorpusFile.h"
+
+// Where processes were dispatched relative to the core they last ran on
+struct AffinityStats {
+    uint64_t firstDispatches = 0;   // process had not run before
+    uint64_t affinityHits = 0;      // placed on its last core
+    uint64_t migrations = 0;        // placed on a different core
+    uint64_t coldStarts = 0;        // cache model: core had to warm up
+    uint64_t warmStarts = 0;
+    uint64_t warmupTicks = 0;       // busy ticks spent warming up
+    size_t   held = 0;              // processes currently waiting for their core
+    uint64_t crossCluster = 0;      // topology: migrations to another cluster of the same socket
+    uint64_t crossSocket = 0;       // topology: migrations to another socket
+    uint64_t penaltyTicks = 0;      // topology: migration penalty charged
+};
+
+// Deadline outcomes of finished processes
+struct DeadlineStats {
+    uint64_t met = 0;
+    uint64_t missed = 0;
+    uint64_t maxLateness = 0;   // ticks past the deadline, worst case
+    uint64_t demoted = 0;       // deadline dropped by the admission test
+    size_t   active = 0;        // unfinished processes with a deadline
+};
+
+// Per-process latencies summarized per policy; see Process::Timing
+enum LatencyMetric { LatencyResponse, LatencyWait, LatencyRun, LatencyTurnaround, LatencyMetricCount };
+
+struct LatencySummary {
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t max = 0;
+};
+
+struct PolicyLatency {
+    std::string policy;
+    uint64_t finished = 0;
+    LatencySummary ticks[LatencyMetricCount];
+    LatencySummary nanos[LatencyMetricCount];
+};
+
+// Interpreter counters of all cores added together; see Core
+struct OpcodeProfile {
+    uint64_t executed[Process::OpcodeCount] = {};
+    uint64_t samples[Process::OpcodeCount] = {};       // timed executions
+    uint64_t sampleNanos[Process::OpcodeCount] = {};
+    uint64_t loopBodyInstructions = 0;
+    uint64_t loopIterations = 0;
+};
+
+// Where a workload replay has got to
+struct ReplayProgress {
+    bool     active = false;
+    bool     fast = false;
+    uint64_t submitted = 0;
+    uint64_t total = 0;         // from the file header; 0 if recording never stopped cleanly
+    uint64_t resized = 0;       // recorded memory size did not suit this config; drawn instead
+    std::string error;          // set if the file turned out to be damaged
+};
+
+// The program corpus the generator draws from
+struct CorpusStatus {
+    bool     loaded = false;
+    std::string path;
+    uint64_t programs = 0;
+    uint64_t instructions = 0;
+    uint64_t drawn = 0;         // programs handed to generated processes
+    uint64_t damaged = 0;       // entries skipped for a random program: bad bytecode, or a
+                                // memory size this config cannot admit
+};
+
+// Generator throttling under overload
+struct BackpressureStats {
+    size_t   readyDepth = 0;         // processes waiting for a core
+    size_t   memoryDepth = 0;        // processes waiting for memory
+    uint64_t pendingBytes = 0;       // memory those processes asked for
+    bool     throttled = false;
+    uint64_t throttleEpisodes = 0;
+    uint64_t deferredArrivals = 0;   // pause policy: arrivals still owed
+    uint64_t pausedArrivals = 0;     // pause policy: arrivals ever deferred
+    uint64_t droppedArrivals = 0;    // drop policy
+};
+
+// What one unthrottled generator pass creates: up to batchMax of the
+// arrivals owed since the last pass and, on a budget of their own, up to
+// batchMax of the ones deferred while throttled. With a separate budget a
+// steady arrival rate cannot starve the deferred arrivals.
+struct ArrivalPlan {
+    size_t fresh = 0;
+    size_t resumed = 0;
+};
+
+inline ArrivalPlan planArrivals(uint64_t owed, uint64_t deferred, size_t batchMax) {
+    ArrivalPlan plan;
+    plan.fresh = static_cast<size_t>(owed < batchMax ? owed : batchMax);
+    plan.resumed = static_cast<size_t>(deferred < batchMax ? deferred : batchMax);
+    return plan;
+}
 
 class Scheduler {
 public:
@@ -25,10 +136,21 @@ public:
     void start();
     void stop();
     void submit(std::shared_ptr<Process> p);
+    // Submits a group with one admission lock and one ready-queue lock
+    void submitBatch(const std::vector<std::shared_ptr<Process>>& processes);
+    // Most processes the generator creates per pass when it has fallen behind
+    // batch-process-freq, and again for arrivals deferred by backpressure
+    // (see planArrivals); 1 keeps one process of each per pass
+    void setBatchSubmitMax(size_t count) { batchSubmitMax_ = count < 1 ? 1 : count; }
     void notifyProcessFinished();
     void requeueProcess(std::shared_ptr<Process> p);
+    // Called by a core whose slice was cut short by Core::preempt. The
+    // process re-enters the ready queue as new work would, so MLFQ does not
+    // count it against its quantum.
+    void requeuePreempted(std::shared_ptr<Process> p);
     void startProcessGeneration();
     void stopProcessGeneration();
+    bool isGenerating() const { return processGenEnabled_.load(); }
     void waitUntilAllDone();
 
     void addFinishedProcess(std::shared_ptr<Process> p);
@@ -39,41 +161,227 @@ public:
     std::vector<std::shared_ptr<Process>> getFinishedProcesses() const;
     std::vector<std::shared_ptr<Process>> getSleepingProcesses() const;
 
+    // Busy share of all cores over the last second; the busy-core count
+    // until the first second has been sampled
     double getCpuUtilization() const;
+    // Per-core and total utilization over 1s, 10s and 60s windows
+    std::vector<UtilizationWindow> getUtilization() const { return utilization_.get(); }
     int getCoresUsed() const;
     int getCoresAvailable() const;
 
     void updateCoreUtilization(int coreId, uint64_t ticksUsed);
     Core* getCore(int index) const;
 
+    // Memory admission
+    void setMemoryRange(int minMemPerProc, int maxMemPerProc);
+    void setAdmissionMaxHeadWait(uint64_t ticks);
+    int drawMemorySize();
+    // Whether a memory size read back from a file suits the current config:
+    // 0 (the default size), or within [min, max]-mem-per-proc and small
+    // enough for one shard. Anything else would sit at the head of the
+    // admission queue forever.
+    bool memorySizeAllowed(int size) const;
+    AdmissionStats getAdmissionStats() const;
+
+    // Bytes the compaction engine may move per scheduler pass; 0 disables it
+    void setCompactionStepBytes(int bytes) { compactionStepBytes_ = bytes; }
+
+    // Share of generated instructions that are READ/WRITE
+    void setMemoryOpRatio(double ratio) { memOpRatio_ = ratio; }
+
+    // Switches the ready-queue policy while running. Every queued process is
+    // moved to the new policy; running, sleeping and held processes join it
+    // when they next become ready. Returns false for an unknown policy.
+    bool setPolicy(const std::string& name, size_t& migrated);
+    std::string getPolicyName() const;
+
+    // MLFQ settings; used whenever the policy is "mlfq"
+    void configureMlfq(const std::vector<uint64_t>& quantums, uint64_t boostTicks);
+    std::vector<MlfqLevelStats> getMlfqStats() const;
+
+    // Affinity placement: a process whose last core is busy may wait up to
+    // maxWaitTicks for it before it migrates; 0 always takes any free core
+    void configureAffinity(uint64_t maxWaitTicks, uint64_t warmupTicks, uint64_t warmWindow);
+    AffinityStats getAffinityStats() const;
+
+    // Adaptive quantum, applied while the policy is "rr"; see QuantumController
+    // for how it is chosen
+    void configureAdaptiveQuantum(uint64_t minQuantum, uint64_t maxQuantum, uint64_t responseTargetTicks,
+        double maxOverhead, uint64_t adjustTicks, const std::string& logPath);
+    bool hasAdaptiveQuantum() const { return adaptiveQuantum_ != nullptr; }
+    QuantumStats getQuantumStats() const;
+
+    // Ready-queue lock acquisitions, and how many processes were dispatched
+    uint64_t getReadyQueueLockAcquisitions() const;
+    uint64_t getDispatchCount() const;
+
+    // Opcode mix, loop share and sampled opcode timing over all cores
+    OpcodeProfile getOpcodeProfile() const;
+
+    // Generator backpressure. Arrivals are throttled once the backlog (ready
+    // plus waiting for memory) reaches backlogHigh or the memory asked for by
+    // waiting processes reaches memoryHigh, and resume once both are at or
+    // below their low marks. A high mark of 0 disables that check.
+    // dropArrivals discards throttled arrivals; otherwise they are deferred
+    // and generated after the backlog drains.
+    void configureBackpressure(size_t backlogHigh, size_t backlogLow, uint64_t memoryHigh,
+        uint64_t memoryLow, bool dropArrivals);
+    BackpressureStats getBackpressureStats();
+
+    // Deadlines for generated processes: a share of them get a relative
+    // deadline drawn from [minTicks, maxTicks]; maxTicks 0 disables this.
+    // With admissionTest, a deadline is only kept if the total density of
+    // deadline work (remaining instructions / ticks to deadline) stays within
+    // densityBound of what the cores can execute, at the per-core rate
+    // measured while running, and the process alone fits on one core.
+    // Otherwise it runs best effort.
+    void configureDeadlines(uint64_t minTicks, uint64_t maxTicks, double share,
+        bool admissionTest, double densityBound);
+    DeadlineStats getDeadlineStats() const;
+
+    // Core topology. Under fcfs and rr, each cluster gets its own run queue and
+    // idle clusters steal hierarchically; every policy pays the migration
+    // penalties when a process changes cluster or socket.
+    void configureTopology(const TopologyShape& shape, uint64_t clusterPenalty, uint64_t socketPenalty);
+    bool hasTopology() const { return topologySet_; }
+    const TopologyShape& getTopology() const { return topology_; }
+    TopologyStats getTopologyStats() const;
+
+    // Fair-share groups as (name, tickets). The stride policy divides core
+    // ticks by ticket share; under every policy generated processes are
+    // tagged with the groups in turn.
+    void configureGroups(const std::vector<std::pair<std::string, uint32_t>>& groups);
+    std::vector<GroupShareStats> getGroupStats() const;
+
+    // Mean finish-minus-arrival over finished processes, in CPU ticks
+    double getMeanTurnaroundTicks() const;
+    // Latency percentiles of finished processes, keyed by the policy active
+    // when each finished
+    std::vector<PolicyLatency> getLatencyStats() const;
+
+    // Scheduling event trace; cores record their own events through it
+    EventTracer& tracer() { return tracer_; }
+
+    // Publishes a snapshot of core states, queue depths and utilization to
+    // the named shared-memory segment once per scheduler pass, for readers
+    // such as csopesy-top. Returns false if the segment cannot be created.
+    bool configureStatsSegment(const std::string& name);
+
+    // Workload recording: the name, program, memory size, group, deadline
+    // and arrival tick of every process submitted from now on are written
+    // to path (see WorkloadFile.h). stopRecording returns how many.
+    bool startRecording(const std::string& path);
+    uint64_t stopRecording();
+    bool isRecording() const { return recording_.load(); }
+
+    // Replays a recorded workload: each process is submitted at its recorded
+    // arrival tick, counted from when the replay starts. With fast, stretches
+    // in which nothing is running, ready or waiting for memory are skipped by
+    // moving the tick counter on to the next arrival or wake-up.
+    bool startReplay(const std::string& path, bool fast, std::string& error);
+    void stopReplay();
+    bool isReplaying() const { return replayEnabled_.load(); }
+    ReplayProgress getReplayProgress() const;
+
+    // Program corpus (see CorpusFile.h). While one is loaded, generated
+    // processes run its programs in file order, wrapping around at the end,
+    // straight from the mapped file; a program's memory size comes from the
+    // corpus unless it is 0. Both refuse while the generator is running.
+    bool loadCorpus(const std::string& path, std::string& error);
+    bool clearCorpus(std::string& error);
+    CorpusStatus getCorpusStatus() const;
+    // Writes a corpus of programs generated as the generator would, each
+    // with the memory size its addresses were drawn for
+    bool buildCorpus(const std::string& path, uint64_t programs, std::string& error);
+
+    // Checkpoint and restore (see Checkpoint.h). writeCheckpoint pauses
+    // dispatching, preempts every core and saves the ready, sleeping,
+    // memory-wait and finished processes with their full state, the memory
+    // layout and contents, the tick counter and the policy, then carries on.
+    // restoreCheckpoint loads such a file into an emulator that has no
+    // processes yet. Both refuse while the generator or a replay is running.
+    // Cumulative statistics (latency, utilization, counters) are not saved.
+    bool writeCheckpoint(const std::string& path, CheckpointSummary& summary, std::string& error);
+    bool restoreCheckpoint(const std::string& path, CheckpointSummary& summary, std::string& error);
+
+    // Exposes counters and gauges in the Prometheus text format every
+    // intervalMs, to a file or to "unix:<path>"; see MetricsExporter.
+    // Returns false if the target cannot be opened.
+    bool configureMetrics(const std::string& target, uint64_t intervalMs);
+    const MetricsExporter* metrics() const { return metrics_.get(); }
+    std::string renderMetrics();
+
 private:
     void schedulerLoop();
+    // Parks the scheduler loop at the top of its pass and waits until no
+    // core is running anything; resumeScheduling lets the loop carry on
+    void pauseScheduling();
+    void resumeScheduling();
     void processGeneratorLoop();
+    void compactMemory();
+    void dispatchReady();
+    int findFreeCore() const;
+    bool assignToCore(int index, std::shared_ptr<Process> p);
+
+    // Ready-queue operations for the configured policy
+    void enqueueReady(std::shared_ptr<Process> p);
+    void enqueueReadyMany(std::vector<std::shared_ptr<Process>>& processes);
+    bool popReady(std::shared_ptr<Process>& p);
+    bool popReadyFor(int core, std::shared_ptr<Process>& p);
+    size_t popReadyMany(std::vector<std::shared_ptr<Process>>& out, size_t maxCount);
+    size_t countFreeCores() const;
+    void placeReady(std::shared_ptr<Process> p, uint64_t now);
+    void markFinished(const std::shared_ptr<Process>& p);
+    void dispatchTopology();
+    void prepareArrival(const std::shared_ptr<Process>& p, uint64_t now);
+    void replayLoop();
+    void skipIdleTicks(uint64_t until);
+    void sampleCoreRate();
+    void sampleUtilization();
+    void publishStats();
+    size_t readyDepth();
+    bool updateThrottle();
+    uint64_t migrationPenalty(int fromCore, int toCore, int& level) const;
+    uint64_t quantumFor(const Process& p) const;
+    PolicySettings policySettings() const;
+    void rebuildPolicy();
 
     int numCpus_;
     int nextCoreIndex_ = 0;
-    std::string schedulerType_;
     uint64_t quantumCycles_;
     uint64_t batchProcessFreq_;
+    size_t batchSubmitMax_ = 1;
     uint64_t minInstructions_;
     uint64_t maxInstructions_;
     uint64_t delayPerExec_;
 
     std::vector<std::unique_ptr<Core>> cores_;
-    TSQueue<std::shared_ptr<Process>> readyQueue_;
 
-    mutable std::mutex runningProcessesMutex_;
+    // Shared for queue operations, exclusive while the policy is replaced
+    mutable std::shared_mutex policyMutex_;
+    std::unique_ptr<SchedulingPolicy> policy_;
+    uint64_t retiredLockAcquisitions_ = 0;   // from replaced policies
+
+    mutable ProfiledMutex runningProcessesMutex_{ "Scheduler::runningProcessesMutex_" };
     std::vector<std::shared_ptr<Process>> runningProcesses_;
 
-    mutable std::mutex finishedProcessesMutex_;
+    mutable ProfiledMutex finishedProcessesMutex_{ "Scheduler::finishedProcessesMutex_" };
     std::vector<std::shared_ptr<Process>> finishedProcesses_;
     std::unordered_set<int> finishedPIDs_;
+    struct LatencyHistograms {
+        uint64_t finished = 0;
+        LatencyHistogram ticks[LatencyMetricCount];
+        LatencyHistogram nanos[LatencyMetricCount];
+    };
+    std::map<std::string, LatencyHistograms> latencyByPolicy_;   // under finishedProcessesMutex_
 
-    mutable std::mutex sleepingProcessesMutex_;
+    mutable ProfiledMutex sleepingProcessesMutex_{ "Scheduler::sleepingProcessesMutex_" };
     std::vector<std::shared_ptr<Process>> sleepingProcesses_;
 
     std::thread schedulerThread_;
     std::atomic<bool> running_ = false;
+    std::atomic<bool> pauseRequested_ = false;
+    std::atomic<bool> paused_ = false;       // the loop is parked
 
     std::thread processGenThread_;
     std::atomic<bool> processGenEnabled_ = false;
@@ -84,11 +392,93 @@ private:
 
     std::vector<std::unique_ptr<std::atomic<uint64_t>>> coreTicksUsed_;
     std::atomic<uint64_t> schedulerStartTime_ = 0;
+    UtilizationTracker utilization_;
+    std::vector<uint64_t> busySample_;  // scheduler thread only
 
     MemoryManager& memoryManager_;
     uint64_t lastQuantumSnapshot_ = 0;
     int quantumIndex_ = 0;
 
-    std::queue<std::shared_ptr<Process>> memoryPendingQueue;
+    AdmissionController admission_;
+    int minMemPerProc_;
+    int maxMemPerProc_;
+    int compactionStepBytes_ = 0;
+    EventTracer tracer_;
+    std::unique_ptr<StatsSegment> statsSegment_;
+    std::unique_ptr<MetricsExporter> metrics_;
+
+    WorkloadRecorder recorder_;             // internally locked
+    std::atomic<bool> recording_ = false;
+    std::thread replayThread_;
+    std::atomic<bool> replayEnabled_ = false;
+    bool replayFast_ = false;
+    std::unique_ptr<WorkloadReader> replayReader_;   // replay thread only while it runs
+    std::atomic<uint64_t> replaySubmitted_ = 0;
+    std::atomic<uint64_t> replayResized_ = 0;
+    uint64_t replayTotal_ = 0;
+    mutable std::mutex replayMutex_;        // replayError_
+    std::string replayError_;
+    double memOpRatio_ = 0.0;
+
+    std::shared_ptr<const CorpusFile> corpus_;  // replaced only while the generator is stopped
+    uint64_t corpusNext_ = 0;                   // generator only
+    std::atomic<uint64_t> corpusDrawn_ = 0;
+    std::atomic<uint64_t> corpusDamaged_ = 0;
+
+    std::vector<uint64_t> mlfqQuantums_;   // empty: MLFQ defaults from quantumCycles_
+    uint64_t mlfqBoostTicks_ = 100000;
+
+    std::unique_ptr<QuantumController> adaptiveQuantum_;
+
+    bool topologySet_ = false;
+    TopologyShape topology_;
+    uint64_t clusterPenalty_ = 0;
+    uint64_t socketPenalty_ = 0;
+    std::atomic<uint64_t> crossCluster_ = 0;
+    std::atomic<uint64_t> crossSocket_ = 0;
+    std::atomic<uint64_t> penaltyTicks_ = 0;
+
+    size_t backlogHigh_ = 0;
+    size_t backlogLow_ = 0;
+    uint64_t memoryHigh_ = 0;
+    uint64_t memoryLow_ = 0;
+    bool dropArrivals_ = false;
+    std::atomic<bool> throttled_ = false;
+    std::atomic<uint64_t> throttleEpisodes_ = 0;
+    std::atomic<uint64_t> deferredArrivals_ = 0;
+    std::atomic<uint64_t> pausedArrivals_ = 0;
+    std::atomic<uint64_t> droppedArrivals_ = 0;
+
+    uint64_t deadlineMin_ = 0;
+    uint64_t deadlineMax_ = 0;
+    double deadlineShare_ = 1.0;
+    bool deadlineAdmissionTest_ = false;
+    double densityBound_ = 1.0;
+    mutable ProfiledMutex deadlineMutex_{ "Scheduler::deadlineMutex_" };
+    std::vector<std::shared_ptr<Process>> activeDeadlines_;
+    uint64_t deadlinesMet_ = 0;
+    uint64_t deadlinesMissed_ = 0;
+    uint64_t maxLateness_ = 0;
+    uint64_t deadlinesDemoted_ = 0;
+    double instrPerCoreTick_ = 0.0;   // smoothed instructions a busy core runs per tick
+    uint64_t lastRateTick_ = 0;
+    uint64_t lastRateUsed_ = 0;
+
+    std::vector<std::pair<std::string, uint32_t>> groups_;
+    std::vector<std::string> groupNames_;
+    size_t nextGroup_ = 0;  // generator only
+
+    // At most one process per core waiting for that core to free up.
+    // Only the scheduler thread touches holds_.
+    struct AffinityHold {
+        std::shared_ptr<Process> process;
+        uint64_t since = 0;
+    };
+    std::vector<AffinityHold> holds_;
+    uint64_t affinityMaxWait_ = 0;
+    std::atomic<uint64_t> firstDispatches_ = 0;
+    std::atomic<uint64_t> affinityHits_ = 0;
+    std::atomic<uint64_t> migrations_ = 0;
+    std::atomic<size_t> heldCount_ = 0;
 
 };
@@ -0,0 +1,104 @@
+#include "SchedulingPolicy.h"
+
+void SchedulingPolicy::enqueueMany(std::vector<std::shared_ptr<Process>>& processes, uint64_t now) {
+    for (auto& p : processes) enqueue(std::move(p), now);
+    processes.clear();
+}
+
+size_t SchedulingPolicy::pickMany(std::vector<std::shared_ptr<Process>>& out, size_t maxCount, uint64_t now) {
+    size_t taken = 0;
+    std::shared_ptr<Process> p;
+    while (taken < maxCount && pickNext(p, now)) {
+        out.push_back(std::move(p));
+        taken++;
+    }
+    return taken;
+}
+
+size_t SchedulingPolicy::drain(std::vector<std::shared_ptr<Process>>& out) {
+    size_t taken = 0;
+    std::shared_ptr<Process> p;
+    while (pickNext(p, 0)) {
+        out.push_back(std::move(p));
+        taken++;
+    }
+    return taken;
+}
+
+FifoPolicy::FifoPolicy(const std::string& name, uint64_t quantum, QuantumController* adaptive)
+    : SchedulingPolicy(name), quantum_(quantum), adaptive_(adaptive) {
+}
+
+void FifoPolicy::enqueueMany(std::vector<std::shared_ptr<Process>>& processes, uint64_t /*now*/) {
+    queue_.push_many(processes);
+}
+
+size_t FifoPolicy::pickMany(std::vector<std::shared_ptr<Process>>& out, size_t maxCount, uint64_t /*now*/) {
+    return queue_.pop_many(out, maxCount);
+}
+
+uint64_t FifoPolicy::quantumFor(const Process& /*p*/) const {
+    if (adaptive_) return adaptive_->current();
+    return quantum_;
+}
+
+ClusterPolicy::ClusterPolicy(const std::string& name, const TopologyShape& shape, uint64_t quantum,
+    QuantumController* adaptive)
+    : SchedulingPolicy(name), queues_(shape), quantum_(quantum), adaptive_(adaptive) {
+}
+
+bool ClusterPolicy::pickNextFor(int core, std::shared_ptr<Process>& p, uint64_t /*now*/) {
+    if (queues_.size() == 0) return false;
+    return queues_.popFor(queues_.clusterOf(core), p);
+}
+
+uint64_t ClusterPolicy::quantumFor(const Process& /*p*/) const {
+    if (adaptive_) return adaptive_->current();
+    return quantum_;
+}
+
+MlfqPolicy::MlfqPolicy(const std::vector<uint64_t>& quantums, uint64_t boostTicks)
+    : SchedulingPolicy("mlfq"), queue_(quantums), boostTicks_(boostTicks) {
+}
+
+void MlfqPolicy::onTick(uint64_t now) {
+    if (boostTicks_ == 0) return;
+    if (now - lastBoostTick_ >= boostTicks_) {
+        queue_.boost();
+        lastBoostTick_ = now;
+    }
+}
+
+bool isSchedulingPolicyName(const std::string& name) {
+    return name == "fcfs" || name == "rr" || name == "mlfq" || name == "sjf" || name == "srtf" ||
+        name == "stride" || name == "edf";
+}
+
+bool usesQuantumCycles(const std::string& name) {
+    return name == "rr" || name == "srtf" || name == "stride" || name == "edf";
+}
+
+std::unique_ptr<SchedulingPolicy> makeSchedulingPolicy(const std::string& name, const PolicySettings& settings) {
+    // srtf preempts at quantum boundaries so a shorter arrival can run next;
+    // stride charges groups per quantum and edf rechecks deadlines at each
+    // quantum boundary, so both are preemptive as well
+    if (name == "fcfs" || name == "rr") {
+        uint64_t quantum = name == "rr" ? settings.quantum : UINT64_MAX;
+        QuantumController* adaptive = name == "rr" ? settings.adaptiveQuantum : nullptr;
+        if (settings.topology) return std::make_unique<ClusterPolicy>(name, *settings.topology, quantum, adaptive);
+        return std::make_unique<FifoPolicy>(name, quantum, adaptive);
+    }
+    if (name == "mlfq") {
+        std::vector<uint64_t> quantums = settings.mlfqQuantums;
+        if (quantums.empty()) {
+            // Default: three levels, each quantum twice the one above it
+            quantums = { settings.quantum, settings.quantum * 2, settings.quantum * 4 };
+        }
+        return std::make_unique<MlfqPolicy>(quantums, settings.mlfqBoostTicks);
+    }
+    if (name == "sjf") return std::make_unique<ShortestWorkPolicy>(name, UINT64_MAX);
+    if (name == "srtf") return std::make_unique<ShortestWorkPolicy>(name, settings.quantum);
+    if (name == "stride") return std::make_unique<StridePolicy>(settings.groups, settings.quantum);
+    if (name == "edf") return std::make_unique<EdfPolicy>(settings.quantum);
+    return nullptr;
+}
@@ -0,0 +1,185 @@
+// SchedulingPolicy.h
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Process.h"
+#include "ThreadedQueue.h"
+#include "MlfqQueue.h"
+#include "KeyedQueue.h"
+#include "StrideQueue.h"
+#include "Topology.h"
+#include "QuantumController.h"
+
+// Everything a policy may need when it is built, at startup or by scheduler-set
+struct PolicySettings {
+    uint64_t quantum = 1;
+    QuantumController* adaptiveQuantum = nullptr;   // rr only
+    std::vector<uint64_t> mlfqQuantums;
+    uint64_t mlfqBoostTicks = 0;
+    std::vector<std::pair<std::string, uint32_t>> groups;
+    const TopologyShape* topology = nullptr;        // fcfs/rr get a run queue per cluster
+};
+
+// A ready-queue discipline. The scheduler calls it from the scheduler thread,
+// the core threads and the generator, so implementations must be thread-safe;
+// the queues they wrap already are.
+class SchedulingPolicy {
+public:
+    explicit SchedulingPolicy(std::string name) : name_(std::move(name)) {}
+    virtual ~SchedulingPolicy() = default;
+
+    const std::string& name() const { return name_; }
+
+    // A process that became ready: admitted, submitted, or requeued by a core
+    virtual void enqueue(std::shared_ptr<Process> p, uint64_t now) = 0;
+    virtual void enqueueMany(std::vector<std::shared_ptr<Process>>& processes, uint64_t now);
+    virtual bool pickNext(std::shared_ptr<Process>& p, uint64_t now) = 0;
+    // Next process for a specific core; only differs with per-core queues
+    virtual bool pickNextFor(int /*core*/, std::shared_ptr<Process>& p, uint64_t now) { return pickNext(p, now); }
+    virtual size_t pickMany(std::vector<std::shared_ptr<Process>>& out, size_t maxCount, uint64_t now);
+
+    // p used its whole quantum and is still runnable
+    virtual void onQuantumExpiry(std::shared_ptr<Process> p, uint64_t now) { enqueue(std::move(p), now); }
+    // p finished sleeping
+    virtual void onWake(std::shared_ptr<Process> p, uint64_t now) { enqueue(std::move(p), now); }
+    virtual void onFinish(Process& /*p*/) {}
+    // Once per scheduler pass
+    virtual void onTick(uint64_t /*now*/) {}
+
+    // Ticks p may run before it is preempted; UINT64_MAX runs it to completion
+    virtual uint64_t quantumFor(const Process& p) const = 0;
+    virtual size_t size() = 0;
+    virtual bool perCoreQueues() const { return false; }
+    virtual uint64_t queueLockAcquisitions() const { return 0; }
+
+    // Removes every queued process, in the order the policy would run them
+    size_t drain(std::vector<std::shared_ptr<Process>>& out);
+
+private:
+    std::string name_;
+};
+
+// "fcfs" and "rr": one FIFO queue
+class FifoPolicy : public SchedulingPolicy {
+public:
+    FifoPolicy(const std::string& name, uint64_t quantum, QuantumController* adaptive);
+
+    void enqueue(std::shared_ptr<Process> p, uint64_t /*now*/) override { queue_.push(std::move(p)); }
+    void enqueueMany(std::vector<std::shared_ptr<Process>>& processes, uint64_t now) override;
+    bool pickNext(std::shared_ptr<Process>& p, uint64_t /*now*/) override { return queue_.try_pop(p); }
+    size_t pickMany(std::vector<std::shared_ptr<Process>>& out, size_t maxCount, uint64_t now) override;
+    uint64_t quantumFor(const Process& p) const override;
+    size_t size() override { return queue_.size(); }
+    uint64_t queueLockAcquisitions() const override { return queue_.lockAcquisitions(); }
+
+private:
+    TSQueue<std::shared_ptr<Process>> queue_;
+    uint64_t quantum_;
+    QuantumController* adaptive_;
+};
+
+// "fcfs" and "rr" with a topology: a FIFO per cluster with hierarchical stealing
+class ClusterPolicy : public SchedulingPolicy {
+public:
+    ClusterPolicy(const std::string& name, const TopologyShape& shape, uint64_t quantum,
+        QuantumController* adaptive);
+
+    void enqueue(std::shared_ptr<Process> p, uint64_t /*now*/) override { queues_.push(std::move(p)); }
+    bool pickNext(std::shared_ptr<Process>& p, uint64_t /*now*/) override { return queues_.popFor(0, p); }
+    bool pickNextFor(int core, std::shared_ptr<Process>& p, uint64_t now) override;
+    uint64_t quantumFor(const Process& p) const override;
+    size_t size() override { return queues_.size(); }
+    bool perCoreQueues() const override { return true; }
+
+    TopologyStats getStats() const { return queues_.getStats(); }
+
+private:
+    TopologyRunQueues queues_;
+    uint64_t quantum_;
+    QuantumController* adaptive_;
+};
+
+// "mlfq": demotes on quantum expiry and boosts every boostTicks
+class MlfqPolicy : public SchedulingPolicy {
+public:
+    MlfqPolicy(const std::vector<uint64_t>& quantums, uint64_t boostTicks);
+
+    void enqueue(std::shared_ptr<Process> p, uint64_t now) override { queue_.push(std::move(p), now); }
+    bool pickNext(std::shared_ptr<Process>& p, uint64_t now) override { return queue_.try_pop(p, now); }
+    void onQuantumExpiry(std::shared_ptr<Process> p, uint64_t now) override { queue_.pushDemoted(std::move(p), now); }
+    void onTick(uint64_t now) override;
+    uint64_t quantumFor(const Process& p) const override { return queue_.quantumFor(p); }
+    size_t size() override { return queue_.size(); }
+
+    std::vector<MlfqLevelStats> getStats() { return queue_.getStats(); }
+
+private:
+    MlfqQueue queue_;
+    uint64_t boostTicks_;
+    uint64_t lastBoostTick_ = 0;   // scheduler thread only
+};
+
+// "sjf" and "srtf": least remaining work (expanded instruction count, FOR loops
+// included) first; requeues re-key the process
+class ShortestWorkPolicy : public SchedulingPolicy {
+public:
+    ShortestWorkPolicy(const std::string& name, uint64_t quantum)
+        : SchedulingPolicy(name), queue_([](const Process& p) { return p.getRemainingWork(); }), quantum_(quantum) {}
+
+    void enqueue(std::shared_ptr<Process> p, uint64_t /*now*/) override { queue_.push(std::move(p)); }
+    bool pickNext(std::shared_ptr<Process>& p, uint64_t /*now*/) override { return queue_.try_pop(p); }
+    uint64_t quantumFor(const Process& /*p*/) const override { return quantum_; }
+    size_t size() override { return queue_.size(); }
+
+private:
+    KeyedQueue queue_;
+    uint64_t quantum_;
+};
+
+// "stride": fair share across process groups; pushes and finishes charge the group
+class StridePolicy : public SchedulingPolicy {
+public:
+    StridePolicy(const std::vector<std::pair<std::string, uint32_t>>& groups, uint64_t quantum)
+        : SchedulingPolicy("stride"), queue_(groups), quantum_(quantum) {}
+
+    void enqueue(std::shared_ptr<Process> p, uint64_t /*now*/) override { queue_.push(std::move(p)); }
+    bool pickNext(std::shared_ptr<Process>& p, uint64_t /*now*/) override { return queue_.try_pop(p); }
+    void onFinish(Process& p) override { queue_.charge(p); }
+    uint64_t quantumFor(const Process& /*p*/) const override { return quantum_; }
+    size_t size() override { return queue_.size(); }
+
+    std::vector<GroupShareStats> getStats() { return queue_.getStats(); }
+
+private:
+    StrideQueue queue_;
+    uint64_t quantum_;
+};
+
+// "edf": earliest deadline first, rechecked at every quantum boundary
+class EdfPolicy : public SchedulingPolicy {
+public:
+    // Processes without a deadline sort after every process that has one
+    explicit EdfPolicy(uint64_t quantum)
+        : SchedulingPolicy("edf"),
+        queue_([](const Process& p) { return p.hasDeadline() ? p.getDeadline() : UINT64_MAX; }), quantum_(quantum) {}
+
+    void enqueue(std::shared_ptr<Process> p, uint64_t /*now*/) override { queue_.push(std::move(p)); }
+    bool pickNext(std::shared_ptr<Process>& p, uint64_t /*now*/) override { return queue_.try_pop(p); }
+    uint64_t quantumFor(const Process& /*p*/) const override { return quantum_; }
+    size_t size() override { return queue_.size(); }
+
+private:
+    KeyedQueue queue_;
+    uint64_t quantum_;
+};
+
+bool isSchedulingPolicyName(const std::string& name);
+// Policies that preempt every quantum-cycles ticks and so need it to be at least 1
+bool usesQuantumCycles(const std::string& name);
+
+// nullptr if name is not a known policy
+std::unique_ptr<SchedulingPolicy> makeSchedulingPolicy(const std::string& name, const PolicySettings& settings);
@@ -0,0 +1,58 @@
+// SoftTlb.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Small fully associative software TLB caching (pid, virtual page) -> frame.
+// Entries are tagged with the pid, so a context switch needs no flush. The
+// whole TLB is dropped when the allocator's mapping epoch changes (a block
+// was freed or relocated). Owned by one core; only that core's worker
+// thread looks it up.
+class SoftTlb {
+public:
+    explicit SoftTlb(size_t entries = 16) : entries_(entries == 0 ? 1 : entries) {}
+
+    bool lookup(int pid, uint32_t vpn, uint64_t epoch, uint32_t& frame) {
+        if (epoch != epoch_) {
+            flush();
+            epoch_ = epoch;
+        }
+        for (const auto& e : entries_) {
+            if (e.valid && e.pid == pid && e.vpn == vpn) {
+                frame = e.frame;
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    void insert(int pid, uint32_t vpn, uint32_t frame) {
+        Entry& e = entries_[next_];
+        next_ = (next_ + 1) % entries_.size();  // round-robin replacement
+        e = { pid, vpn, frame, true };
+    }
+
+    void flush() {
+        for (auto& e : entries_) e.valid = false;
+    }
+
+    uint64_t getHits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t getMisses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        int pid = -1;
+        uint32_t vpn = 0;
+        uint32_t frame = 0;
+        bool valid = false;
+    };
+
+    std::vector<Entry> entries_;
+    size_t next_ = 0;
+    uint64_t epoch_ = 0;
+    std::atomic<uint64_t> hits_{ 0 };
+    std::atomic<uint64_t> misses_{ 0 };
+};
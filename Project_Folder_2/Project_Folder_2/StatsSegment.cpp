@@ -0,0 +1,69 @@
+#include "StatsSegment.h"
+#include <cstring>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+StatsSegment::StatsSegment(const std::string& name, uint32_t cores)
+    : name_(name), size_(statsSegmentSize(cores)) {
+    void* memory = nullptr;
+#ifdef _WIN32
+    std::string objectName = "Local\\" + name;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+        static_cast<DWORD>(size_), objectName.c_str());
+    if (!mapping) return;
+    memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size_);
+    if (!memory) {
+        CloseHandle(mapping);
+        return;
+    }
+    mapping_ = mapping;
+#else
+    std::string objectName = "/" + name;
+    int fd = shm_open(objectName.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return;
+    if (ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+        close(fd);
+        return;
+    }
+    memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return;
+#endif
+
+    std::memset(memory, 0, size_);
+    header_ = new (memory) StatsSegmentHeader();
+    header_->sequence.store(0);
+    std::memcpy(header_->snapshot.magic, "CSSTATS1", 8);
+    header_->snapshot.version = 1;
+    header_->snapshot.cores = cores;
+}
+
+StatsSegment::~StatsSegment() {
+    if (!header_) return;
+#ifdef _WIN32
+    UnmapViewOfFile(header_);
+    CloseHandle(static_cast<HANDLE>(mapping_));
+#else
+    munmap(header_, size_);
+    shm_unlink(("/" + name_).c_str());
+#endif
+}
+
+StatsSegmentHeader* StatsSegment::beginWrite() {
+    uint64_t seq = header_->sequence.load(std::memory_order_relaxed);
+    header_->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return header_;
+}
+
+void StatsSegment::endWrite() {
+    header_->snapshot.publishes++;
+    header_->sequence.store(header_->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,79 @@
+// StatsSegment.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Layout of the shared-memory stats segment: a StatsSegmentHeader followed
+// by one StatsCoreEntry per core. Everything after the sequence counter is
+// plain data, so readers can copy it out while the emulator keeps running.
+struct StatsSnapshot {
+    char     magic[8];          // "CSSTATS1"
+    uint32_t version;
+    uint32_t cores;
+    uint64_t publishes;         // snapshots written so far
+    uint64_t tick;              // globalCpuTicks
+    int64_t  wallMillis;        // system clock when published
+    char     policy[16];
+    uint64_t readyDepth;        // waiting for a core, affinity holds included
+    uint64_t memoryDepth;       // waiting for memory
+    uint64_t sleeping;
+    uint64_t running;
+    uint64_t finished;
+    uint64_t active;            // submitted and not finished
+    uint64_t dispatches;
+    uint32_t throttled;         // generator backpressure engaged
+    uint32_t tracing;
+    double   utilization[3];    // all cores over 1s, 10s, 60s, 0-100
+};
+
+struct StatsCoreEntry {
+    int32_t  pid;               // -1 when idle
+    uint32_t busy;
+    uint64_t busyTicks;         // cumulative
+    double   utilization1s;
+    double   utilization10s;
+};
+static_assert(sizeof(StatsCoreEntry) == 32, "StatsCoreEntry must stay 32 bytes");
+
+struct StatsSegmentHeader {
+    // Seqlock: odd while a snapshot is being written. Readers copy the
+    // snapshot and the core entries, then retry if the counter was odd or
+    // changed in between.
+    std::atomic<uint64_t> sequence;
+    uint64_t reserved;
+    StatsSnapshot snapshot;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock needs a lock-free 64-bit atomic");
+
+inline size_t statsSegmentSize(uint32_t cores) {
+    return sizeof(StatsSegmentHeader) + static_cast<size_t>(cores) * sizeof(StatsCoreEntry);
+}
+
+inline StatsCoreEntry* statsCoreEntries(StatsSegmentHeader* header) {
+    return reinterpret_cast<StatsCoreEntry*>(header + 1);
+}
+
+// Named shared-memory segment the scheduler thread publishes into once per
+// pass ("/name" under POSIX, "Local\name" on Windows). Only one thread may
+// write; readers never block it.
+class StatsSegment {
+public:
+    StatsSegment(const std::string& name, uint32_t cores);
+    ~StatsSegment();
+
+    bool isOpen() const { return header_ != nullptr; }
+
+    // Returns the snapshot and core entries to fill in, with the sequence odd
+    StatsSegmentHeader* beginWrite();
+    void endWrite();
+
+private:
+    std::string name_;
+    size_t size_ = 0;
+    StatsSegmentHeader* header_ = nullptr;
+#ifdef _WIN32
+    void* mapping_ = nullptr;
+#endif
+};
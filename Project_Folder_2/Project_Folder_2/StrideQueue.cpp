@@ -0,0 +1,106 @@
+#include "StrideQueue.h"
+
+namespace {
+const uint64_t Stride1 = 1ULL << 20;  // stride of a group holding one ticket
+}
+
+const char* const StrideQueue::DefaultGroup = "default";
+
+StrideQueue::StrideQueue(const std::vector<std::pair<std::string, uint32_t>>& groups) {
+    auto add = [this](const std::string& name, uint32_t tickets) {
+        Group group;
+        group.name = name;
+        group.tickets = tickets < 1 ? 1 : tickets;
+        group.stride = Stride1 / group.tickets;
+        // A repeated name maps to its first entry
+        index_.emplace(name, static_cast<int>(groups_.size()));
+        groups_.push_back(std::move(group));
+    };
+    for (const auto& g : groups) add(g.first, g.second);
+    if (!index_.count(DefaultGroup)) {
+        add(DefaultGroup, 1);
+        groups_.back().implicit = true;
+    }
+    defaultIndex_ = index_.at(DefaultGroup);
+}
+
+int StrideQueue::groupOf(const Process& p) const {
+    auto it = index_.find(p.getGroup());
+    return it != index_.end() ? it->second : defaultIndex_;
+}
+
+void StrideQueue::chargeLocked(Process& p) {
+    uint64_t used = p.getCpuTicks() - p.getChargedTicks();
+    if (used == 0) return;
+    p.setChargedTicks(p.getCpuTicks());
+
+    int g = groupOf(p);
+    Group& group = groups_[g];
+    bool queued = !group.queue.empty();
+    if (queued) active_.erase({ group.pass, g });
+    group.pass += group.stride * used;
+    group.ticks += used;
+    if (queued) active_.insert({ group.pass, g });
+}
+
+void StrideQueue::push(std::shared_ptr<Process> p) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    chargeLocked(*p);
+
+    int g = groupOf(*p);
+    Group& group = groups_[g];
+    if (group.queue.empty()) {
+        if (!active_.empty() && group.pass < active_.begin()->first) group.pass = active_.begin()->first;
+        active_.insert({ group.pass, g });
+    }
+    group.queue.push_back(std::move(p));
+    size_++;
+}
+
+bool StrideQueue::try_pop(std::shared_ptr<Process>& p) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_.empty()) return false;
+
+    int g = active_.begin()->second;
+    Group& group = groups_[g];
+    p = std::move(group.queue.front());
+    group.queue.pop_front();
+    if (group.queue.empty()) active_.erase(active_.begin());
+    size_--;
+    return true;
+}
+
+void StrideQueue::charge(Process& p) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    chargeLocked(p);
+}
+
+size_t StrideQueue::size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+std::vector<GroupShareStats> StrideQueue::getStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto listed = [](const Group& g) { return !g.implicit || g.ticks > 0 || !g.queue.empty(); };
+    uint64_t totalTickets = 0, totalTicks = 0;
+    for (const auto& g : groups_) {
+        if (!listed(g)) continue;
+        totalTickets += g.tickets;
+        totalTicks += g.ticks;
+    }
+
+    std::vector<GroupShareStats> out;
+    for (const auto& g : groups_) {
+        if (!listed(g)) continue;
+        GroupShareStats st;
+        st.name = g.name;
+        st.tickets = g.tickets;
+        st.targetShare = totalTickets ? static_cast<double>(g.tickets) / totalTickets : 0.0;
+        st.ticks = g.ticks;
+        st.achievedShare = totalTicks ? static_cast<double>(g.ticks) / totalTicks : 0.0;
+        st.queued = g.queue.size();
+        out.push_back(st);
+    }
+    return out;
+}
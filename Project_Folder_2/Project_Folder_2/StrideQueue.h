@@ -0,0 +1,69 @@
+// StrideQueue.h
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Process.h"
+
+// Share of core ticks per process group
+struct GroupShareStats {
+    std::string name;
+    uint32_t tickets = 0;
+    double   targetShare = 0.0;    // tickets / all tickets
+    uint64_t ticks = 0;            // core ticks charged to the group
+    double   achievedShare = 0.0;  // ticks / all charged ticks
+    size_t   queued = 0;
+};
+
+// Thread-safe stride scheduler over process groups. Each group has a ticket
+// count and a stride inversely proportional to it. The group with the lowest
+// pass value runs next, FIFO within the group, and its pass advances by
+// stride for every core tick its processes used. Groups with queued
+// processes are kept in a set ordered by pass, so a decision is O(log groups).
+// A group that was idle rejoins at the lowest active pass, so it cannot bank
+// credit while it has nothing to run.
+class StrideQueue {
+public:
+    static const char* const DefaultGroup;  // for processes without a known group
+
+    explicit StrideQueue(const std::vector<std::pair<std::string, uint32_t>>& groups);
+
+    // Charges p's group for the ticks p ran since it was last charged, then queues it
+    void push(std::shared_ptr<Process> p);
+    bool try_pop(std::shared_ptr<Process>& p);
+
+    // Charges a process that is leaving the scheduler (finished)
+    void charge(Process& p);
+
+    size_t size();
+    // The implicit default group is only listed once it has been used
+    std::vector<GroupShareStats> getStats();
+
+private:
+    struct Group {
+        std::string name;
+        uint32_t tickets = 1;
+        uint64_t stride = 0;
+        uint64_t pass = 0;
+        uint64_t ticks = 0;
+        std::deque<std::shared_ptr<Process>> queue;
+        bool implicit = false;  // default group added because none was configured
+    };
+
+    int groupOf(const Process& p) const;
+    void chargeLocked(Process& p);
+
+    std::mutex mutex_;
+    std::vector<Group> groups_;
+    std::unordered_map<std::string, int> index_;   // group name -> index in groups_; fixed after construction
+    int defaultIndex_ = 0;
+    std::set<std::pair<uint64_t, int>> active_;  // (pass, group index) of groups with queued processes
+    size_t size_ = 0;
+};
@@ -0,0 +1,127 @@
+#include "Topology.h"
+#include <sstream>
+
+bool parseTopology(const std::string& text, TopologyShape& shape) {
+    std::stringstream ss(text);
+    std::string part;
+    std::vector<int> parts;
+    while (std::getline(ss, part, 'x')) {
+        try {
+            parts.push_back(std::stoi(part));
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+    if (parts.size() != 3 || parts[0] < 1 || parts[1] < 1 || parts[2] < 1) return false;
+    shape.sockets = parts[0];
+    shape.clustersPerSocket = parts[1];
+    shape.coresPerCluster = parts[2];
+    return true;
+}
+
+TopologyRunQueues::TopologyRunQueues(const TopologyShape& shape) : shape_(shape) {
+    for (int i = 0; i < shape_.clusters(); ++i) clusters_.push_back(std::make_unique<Cluster>());
+    for (int i = 0; i < shape_.sockets; ++i) socketDepth_.push_back(std::make_unique<std::atomic<size_t>>(0));
+}
+
+void TopologyRunQueues::push(std::shared_ptr<Process> p) {
+    int cluster;
+    int last = p->getLastCoreId();
+    if (last >= 0 && last < shape_.cores()) {
+        cluster = clusterOf(last);
+    }
+    else {
+        int socket = 0;
+        for (int s = 1; s < shape_.sockets; ++s) {
+            if (socketDepth_[s]->load() < socketDepth_[socket]->load()) socket = s;
+        }
+        int first = socket * shape_.clustersPerSocket;
+        cluster = first;
+        for (int c = first + 1; c < first + shape_.clustersPerSocket; ++c) {
+            if (clusters_[c]->depth.load() < clusters_[cluster]->depth.load()) cluster = c;
+        }
+    }
+
+    Cluster& target = *clusters_[cluster];
+    // Counters change under the queue lock so a pop can never see them go negative
+    std::lock_guard<std::mutex> lock(target.mutex);
+    target.queue.push_back(std::move(p));
+    target.depth++;
+    (*socketDepth_[cluster / shape_.clustersPerSocket])++;
+    total_++;
+}
+
+bool TopologyRunQueues::popFrom(int cluster, std::shared_ptr<Process>& p) {
+    Cluster& source = *clusters_[cluster];
+    std::lock_guard<std::mutex> lock(source.mutex);
+    if (source.queue.empty()) return false;
+    p = std::move(source.queue.front());
+    source.queue.pop_front();
+    source.depth--;
+    (*socketDepth_[cluster / shape_.clustersPerSocket])--;
+    total_--;
+    return true;
+}
+
+// -1 if every cluster of the socket (other than exclude) is empty
+int TopologyRunQueues::busiestClusterIn(int socket, int exclude) const {
+    int best = -1;
+    size_t bestDepth = 0;
+    int first = socket * shape_.clustersPerSocket;
+    for (int c = first; c < first + shape_.clustersPerSocket; ++c) {
+        if (c == exclude) continue;
+        size_t depth = clusters_[c]->depth.load();
+        if (depth > bestDepth) {
+            best = c;
+            bestDepth = depth;
+        }
+    }
+    return best;
+}
+
+bool TopologyRunQueues::popFor(int cluster, std::shared_ptr<Process>& p) {
+    if (popFrom(cluster, p)) {
+        localPops_++;
+        return true;
+    }
+    if (total_.load() == 0) return false;
+
+    int socket = cluster / shape_.clustersPerSocket;
+    int sibling = busiestClusterIn(socket, cluster);
+    if (sibling >= 0 && popFrom(sibling, p)) {
+        clusterSteals_++;
+        return true;
+    }
+
+    // Other sockets, busiest first
+    std::vector<bool> tried(shape_.sockets, false);
+    tried[socket] = true;
+    for (int attempt = 1; attempt < shape_.sockets; ++attempt) {
+        int victim = -1;
+        size_t victimDepth = 0;
+        for (int s = 0; s < shape_.sockets; ++s) {
+            size_t depth = socketDepth_[s]->load();
+            if (!tried[s] && depth > victimDepth) {
+                victim = s;
+                victimDepth = depth;
+            }
+        }
+        if (victim < 0) break;
+        tried[victim] = true;
+        int source = busiestClusterIn(victim, -1);
+        if (source >= 0 && popFrom(source, p)) {
+            socketSteals_++;
+            return true;
+        }
+    }
+    return false;
+}
+
+TopologyStats TopologyRunQueues::getStats() const {
+    TopologyStats st;
+    st.localPops = localPops_.load();
+    st.clusterSteals = clusterSteals_.load();
+    st.socketSteals = socketSteals_.load();
+    return st;
+}
@@ -0,0 +1,72 @@
+// Topology.h
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Process.h"
+
+// sockets -> clusters -> cores. Cores are numbered socket-major, so core i
+// is in cluster i / coresPerCluster and socket i / (clustersPerSocket * coresPerCluster).
+struct TopologyShape {
+    int sockets = 1;
+    int clustersPerSocket = 1;
+    int coresPerCluster = 1;
+
+    int clusters() const { return sockets * clustersPerSocket; }
+    int cores() const { return clusters() * coresPerCluster; }
+};
+
+// Parses "SxCxK" (e.g. "2x4x8"); returns false if malformed or any part < 1
+bool parseTopology(const std::string& text, TopologyShape& shape);
+
+struct TopologyStats {
+    uint64_t localPops = 0;     // taken from the cluster's own queue
+    uint64_t clusterSteals = 0; // taken from another cluster in the same socket
+    uint64_t socketSteals = 0;  // taken from another socket
+};
+
+// One run queue per cluster. A process is queued on the cluster it last ran
+// in; a new process goes to the least loaded cluster of the least loaded
+// socket. An idle cluster steals hierarchically: first from the busiest
+// sibling cluster, then from the busiest cluster of the busiest other socket.
+// Queue depths are kept per cluster and per socket, so placement and
+// stealing cost O(sockets + clusters per socket) and not O(cores).
+class TopologyRunQueues {
+public:
+    explicit TopologyRunQueues(const TopologyShape& shape);
+
+    const TopologyShape& shape() const { return shape_; }
+    int clusterOf(int core) const { return core / shape_.coresPerCluster; }
+    int socketOf(int core) const { return clusterOf(core) / shape_.clustersPerSocket; }
+
+    void push(std::shared_ptr<Process> p);
+    // Next process for a core in cluster, stealing if its queue is empty
+    bool popFor(int cluster, std::shared_ptr<Process>& p);
+
+    size_t size() const { return total_.load(); }
+    TopologyStats getStats() const;
+
+private:
+    struct Cluster {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Process>> queue;
+        std::atomic<size_t> depth{ 0 };
+    };
+
+    bool popFrom(int cluster, std::shared_ptr<Process>& p);
+    int busiestClusterIn(int socket, int exclude) const;
+
+    TopologyShape shape_;
+    std::vector<std::unique_ptr<Cluster>> clusters_;
+    std::vector<std::unique_ptr<std::atomic<size_t>>> socketDepth_;
+    std::atomic<size_t> total_{ 0 };
+
+    std::atomic<uint64_t> localPops_{ 0 };
+    std::atomic<uint64_t> clusterSteals_{ 0 };
+    std::atomic<uint64_t> socketSteals_{ 0 };
+};
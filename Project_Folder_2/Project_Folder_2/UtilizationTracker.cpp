@@ -0,0 +1,66 @@
+#include "UtilizationTracker.h"
+
+namespace {
+const int WindowSeconds[] = { 1, 10, 60 };
+const int SnapshotsPerWindow = 10;
+}
+
+void UtilizationTracker::configure(size_t cores) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cores_ = cores;
+    windows_.clear();
+    for (int seconds : WindowSeconds) windows_.push_back({ seconds, {} });
+    sampled_ = false;
+}
+
+void UtilizationTracker::sample(Clock::time_point when, uint64_t tick, const std::vector<uint64_t>& busyTicks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latest_.when = when;
+    latest_.tick = tick;
+    latest_.busy = busyTicks;
+    sampled_ = true;
+
+    for (auto& w : windows_) {
+        auto spacing = std::chrono::milliseconds(w.seconds * 1000 / SnapshotsPerWindow);
+        if (!w.history.empty() && when - w.history.back().when < spacing) continue;
+        w.history.push_back(latest_);
+        // One more than a window's worth, so the oldest is at least a window old
+        while (w.history.size() > SnapshotsPerWindow + 1) w.history.pop_front();
+    }
+}
+
+std::vector<UtilizationWindow> UtilizationTracker::get() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<UtilizationWindow> out;
+    for (const auto& w : windows_) {
+        UtilizationWindow uw;
+        uw.seconds = w.seconds;
+        uw.perCore.assign(cores_, 0.0);
+        if (!sampled_ || w.history.empty()) {
+            out.push_back(uw);
+            continue;
+        }
+
+        // Newest snapshot that is at least a window old, else the oldest one
+        const Snapshot* from = &w.history.front();
+        for (const auto& s : w.history) {
+            if (latest_.when - s.when < std::chrono::seconds(w.seconds)) break;
+            from = &s;
+        }
+        uw.coveredSeconds = std::chrono::duration<double>(latest_.when - from->when).count();
+        uint64_t elapsed = latest_.tick - from->tick;
+        if (elapsed > 0 && cores_ > 0) {
+            double sum = 0.0;
+            for (size_t i = 0; i < cores_; ++i) {
+                uint64_t busy = latest_.busy[i] > from->busy[i] ? latest_.busy[i] - from->busy[i] : 0;
+                double share = 100.0 * static_cast<double>(busy) / elapsed;
+                if (share > 100.0) share = 100.0;   // a slice ending mid-sample can overshoot slightly
+                uw.perCore[i] = share;
+                sum += share;
+            }
+            uw.total = sum / cores_;
+        }
+        out.push_back(uw);
+    }
+    return out;
+}
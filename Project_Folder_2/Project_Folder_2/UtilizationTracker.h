@@ -0,0 +1,50 @@
+// UtilizationTracker.h
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Busy share over one sliding window, 0-100
+struct UtilizationWindow {
+    int seconds = 0;             // nominal window length
+    double coveredSeconds = 0.0; // shorter than seconds until enough history exists
+    double total = 0.0;          // over all cores
+    std::vector<double> perCore;
+};
+
+// Time-weighted core utilization over 1s, 10s and 60s sliding windows.
+// The scheduler thread samples each core's cumulative busy ticks once per
+// pass; a window compares the newest sample with one taken about a window
+// earlier, so utilization is busy ticks / elapsed global ticks in between.
+// Each window keeps a snapshot every tenth of its length, which bounds the
+// history to a few snapshots per core. Cores never touch the tracker.
+class UtilizationTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void configure(size_t cores);
+
+    // busyTicks[i]: global ticks core i has been busy since startup
+    void sample(Clock::time_point when, uint64_t tick, const std::vector<uint64_t>& busyTicks);
+
+    std::vector<UtilizationWindow> get() const;
+
+private:
+    struct Snapshot {
+        Clock::time_point when;
+        uint64_t tick = 0;
+        std::vector<uint64_t> busy;
+    };
+    struct Window {
+        int seconds;
+        std::deque<Snapshot> history;   // oldest first
+    };
+
+    mutable std::mutex mutex_;
+    size_t cores_ = 0;
+    std::vector<Window> windows_;
+    Snapshot latest_;
+    bool sampled_ = false;
+};
@@ -0,0 +1,106 @@
+#include "WorkloadFile.h"
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+
+namespace {
+const char WorkloadMagic[8] = { 'C', 'S', 'W', 'O', 'R', 'K', 'L', 'D' };
+const uint32_t WorkloadVersion = 1;
+}
+
+WorkloadRecorder::~WorkloadRecorder() {
+    stop();
+}
+
+bool WorkloadRecorder::start(const std::string& path, uint64_t startTick) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (out_.is_open()) return false;
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) return false;
+
+    WorkloadFileHeader header{};
+    std::memcpy(header.magic, WorkloadMagic, sizeof(header.magic));
+    header.version = WorkloadVersion;
+    out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    writer_.resetStrings();
+    lastTick_ = startTick;
+    processes_ = 0;
+    return true;
+}
+
+uint64_t WorkloadRecorder::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!out_.is_open()) return 0;
+    out_.seekp(offsetof(WorkloadFileHeader, processes));
+    out_.write(reinterpret_cast<const char*>(&processes_), sizeof(processes_));
+    out_.close();
+    return processes_;
+}
+
+void WorkloadRecorder::record(const Process& p, uint64_t arrivalTick) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!out_.is_open()) return;
+
+    // Submissions from two threads can reach here slightly out of tick order
+    uint64_t delta = arrivalTick > lastTick_ ? arrivalTick - lastTick_ : 0;
+    lastTick_ += delta;
+
+    writer_.clear();
+    writer_.putVarint(delta);
+    writer_.putString(p.getName());
+    writer_.putVarint(static_cast<uint64_t>(p.getMemorySize() > 0 ? p.getMemorySize() : 0));
+    writer_.putString(p.getGroup());
+    writer_.putVarint(p.getRelativeDeadline());
+    writer_.putProgram(p.getInstructions());
+
+    const auto& buffer = writer_.buffer();
+    out_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    processes_++;
+}
+
+bool WorkloadReader::open(const std::string& path, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + path;
+        return false;
+    }
+    data_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    WorkloadFileHeader header{};
+    if (data_.size() < sizeof(header)) {
+        error = path + " is not a workload file";
+        return false;
+    }
+    std::memcpy(&header, data_.data(), sizeof(header));
+    if (std::memcmp(header.magic, WorkloadMagic, sizeof(header.magic)) != 0) {
+        error = path + " is not a workload file";
+        return false;
+    }
+    if (header.version != WorkloadVersion) {
+        error = path + " has unsupported workload version " + std::to_string(header.version);
+        return false;
+    }
+    processes_ = header.processes;
+    reader_ = PackedReader(data_.data() + sizeof(header), data_.size() - sizeof(header));
+    lastTick_ = 0;
+    error_.clear();
+    return true;
+}
+
+bool WorkloadReader::next(WorkloadEntry& entry) {
+    if (reader_.atEnd()) return false;
+
+    size_t start = reader_.position() + sizeof(WorkloadFileHeader);
+    uint64_t delta, memory;
+    if (!reader_.getVarint(delta) || !reader_.getString(entry.name) || !reader_.getVarint(memory)
+        || !reader_.getString(entry.group) || !reader_.getVarint(entry.relativeDeadline)
+        || !reader_.getProgram(entry.program)) {
+        error_ = "damaged workload record at byte " + std::to_string(start);
+        return false;
+    }
+    lastTick_ += delta;
+    entry.arrivalTick = lastTick_;
+    entry.memorySize = static_cast<int>(memory);
+    return true;
+}
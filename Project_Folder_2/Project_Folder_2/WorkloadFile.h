@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "PackedCodec.h"
+#include "Process.h"
+
+// Workload file: a header followed by one record per arrival, in arrival
+// order, encoded with PackedCodec. A record is
+//   arrival delta (ticks since the previous arrival, or since recording
+//   started), name, memory size, group, relative deadline, program
+// and the program string table is shared by the whole file.
+struct WorkloadFileHeader {
+    char     magic[8];      // "CSWORKLD"
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t processes;     // filled in when recording stops
+};
+static_assert(sizeof(WorkloadFileHeader) == 24, "WorkloadFileHeader must stay 24 bytes");
+
+// One recorded arrival
+struct WorkloadEntry {
+    uint64_t arrivalTick = 0;       // ticks after recording started
+    std::string name;
+    int memorySize = 0;
+    std::string group;
+    uint64_t relativeDeadline = 0;
+    std::vector<Process::Instruction> program;
+};
+
+// Appends arrivals to a workload file. Thread-safe: the generator and the
+// console both submit processes.
+class WorkloadRecorder {
+public:
+    ~WorkloadRecorder();
+
+    // startTick is the tick arrival times are measured from
+    bool start(const std::string& path, uint64_t startTick);
+    // Returns the number of processes recorded
+    uint64_t stop();
+    bool isRecording() const { return out_.is_open(); }
+
+    void record(const Process& p, uint64_t arrivalTick);
+
+private:
+    std::mutex mutex_;
+    std::ofstream out_;
+    PackedWriter writer_;           // one record, written in a single call
+    uint64_t lastTick_ = 0;
+    uint64_t processes_ = 0;
+};
+
+// Reads a workload file front to back. Not thread-safe.
+class WorkloadReader {
+public:
+    // Returns false with error set if the file is missing or not a workload
+    bool open(const std::string& path, std::string& error);
+    uint64_t processCount() const { return processes_; }
+
+    // Returns false at the end, or on a damaged record (error is set then)
+    bool next(WorkloadEntry& entry);
+    const std::string& error() const { return error_; }
+
+private:
+    std::vector<char> data_;
+    PackedReader reader_;
+    uint64_t lastTick_ = 0;
+    uint64_t processes_ = 0;
+    std::string error_;
+};
@@ -0,0 +1,77 @@
+// MemoryCompactionTest.cpp
+// Compaction only slides blocks within their shard. Checks that
+// largestCompactableBlock reports what compaction can actually produce, both
+// when the free memory sits in one shard and when it is split across shards.
+// Exits non-zero on failure.
+#include <iostream>
+
+#include "../Project_Folder_2/MemoryManager.h"
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #cond "\n"; \
+            failures++; \
+        } \
+    } while (0)
+
+bool notPinned(int) { return false; }
+
+void compactFully(MemoryManager& memory) {
+    while (memory.compactStep(1 << 20, notPinned) > 0) {}
+}
+
+// Two 512-byte shards, each filled with four 128-byte blocks. Even pids live
+// in shard 0, odd pids in shard 1.
+void fill(MemoryManager& memory) {
+    for (int pid = 0; pid < 8; ++pid) CHECK(memory.allocate(pid, 128));
+    CHECK(memory.largestFreeBlock() == 0);
+}
+
+void freeSpaceSplitAcrossShards() {
+    MemoryManager memory(1024, 256, 16, 2);
+    fill(memory);
+    // Two 128-byte holes in each shard: 512 bytes free in total
+    memory.deallocate(0);
+    memory.deallocate(4);
+    memory.deallocate(1);
+    memory.deallocate(5);
+    CHECK(memory.largestFreeBlock() == 128);
+    CHECK(memory.largestCompactableBlock() == 256);
+
+    // No amount of compaction makes room for 512 bytes
+    compactFully(memory);
+    CHECK(memory.largestFreeBlock() == 256);
+    CHECK(!memory.allocate(100, 512));
+}
+
+void freeSpaceInOneShard() {
+    MemoryManager memory(1024, 256, 16, 2);
+    fill(memory);
+    memory.deallocate(0);
+    memory.deallocate(4);
+    CHECK(memory.largestFreeBlock() == 128);
+    CHECK(memory.largestCompactableBlock() == 256);
+
+    compactFully(memory);
+    CHECK(memory.largestFreeBlock() == 256);
+    CHECK(memory.allocate(100, 256));
+    CHECK(memory.largestCompactableBlock() == 0);
+}
+
+}
+
+int main() {
+    freeSpaceSplitAcrossShards();
+    freeSpaceInOneShard();
+    if (failures > 0) {
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "MemoryCompactionTest: ok\n";
+    return 0;
+}
@@ -0,0 +1,142 @@
+// CsopesyTop.cpp
+// Live view of a running emulator, read from the shared-memory stats
+// segment (see StatsSegment.h). It only maps the segment read-only and
+// retries on a torn snapshot, so it never takes a lock in the emulator.
+//
+//   csopesy-top                        segment "csopesy-stats", refresh every 200 ms
+//   csopesy-top -s <name>              another stats-segment name
+//   csopesy-top -i <ms> -n <count>     refresh interval, stop after count screens
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../Project_Folder_2/StatsSegment.h"
+
+namespace {
+
+const StatsSegmentHeader* openSegment(const std::string& name) {
+#ifdef _WIN32
+    std::string objectName = "Local\\" + name;
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, objectName.c_str());
+    if (!mapping) return nullptr;
+    // Zero maps the whole segment
+    return static_cast<const StatsSegmentHeader*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    std::string objectName = "/" + name;
+    int fd = shm_open(objectName.c_str(), O_RDONLY, 0);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(StatsSegmentHeader)) {
+        close(fd);
+        return nullptr;
+    }
+    void* memory = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return memory == MAP_FAILED ? nullptr : static_cast<const StatsSegmentHeader*>(memory);
+#endif
+}
+
+// Seqlock read: copies the snapshot and core entries, retrying while the
+// emulator is writing or wrote in between. Gives up after MaxRetries (an
+// emulator that died mid-write leaves the sequence odd for good).
+const int MaxRetries = 1000;
+
+bool readSnapshot(const StatsSegmentHeader* header, StatsSnapshot& snap, std::vector<StatsCoreEntry>& cores,
+    uint64_t& retries) {
+    const StatsCoreEntry* entries = reinterpret_cast<const StatsCoreEntry*>(header + 1);
+    for (int attempt = 0; attempt < MaxRetries; ++attempt, ++retries) {
+        uint64_t before = header->sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::memcpy(&snap, &header->snapshot, sizeof(snap));
+        cores.resize(snap.cores);
+        std::memcpy(cores.data(), entries, cores.size() * sizeof(StatsCoreEntry));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->sequence.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+void render(const StatsSnapshot& snap, const std::vector<StatsCoreEntry>& cores, bool stale, uint64_t retries) {
+    std::ostringstream out;
+    out << "\033[H\033[2J";
+    time_t published = static_cast<time_t>(snap.wallMillis / 1000);
+    char timebuf[32];
+    std::strftime(timebuf, sizeof(timebuf), "%H:%M:%S", std::localtime(&published));
+    out << "csopesy-top  " << timebuf << "  tick " << snap.tick << "  policy " << snap.policy
+        << (snap.throttled ? "  [throttled]" : "") << (snap.tracing ? "  [tracing]" : "")
+        << (stale ? "  (emulator not publishing)" : "") << "\n";
+    out << std::fixed << std::setprecision(1);
+    out << "CPU  " << snap.utilization[0] << "% 1s  " << snap.utilization[1] << "% 10s  "
+        << snap.utilization[2] << "% 60s   running " << snap.running << "/" << snap.cores << "\n";
+    out << "Processes  active " << snap.active << "  ready " << snap.readyDepth << "  memory wait "
+        << snap.memoryDepth << "  sleeping " << snap.sleeping << "  finished " << snap.finished
+        << "  dispatches " << snap.dispatches << "\n";
+    out << "snapshot " << snap.publishes << ", " << retries << " torn reads retried\n\n";
+    out << std::left << std::setw(7) << "CORE" << std::setw(9) << "PID" << std::setw(9) << "1s%"
+        << std::setw(9) << "10s%" << "BUSY TICKS\n";
+    for (size_t i = 0; i < cores.size(); ++i) {
+        const StatsCoreEntry& c = cores[i];
+        out << std::setw(7) << i << std::setw(9) << (c.pid >= 0 ? "p" + std::to_string(c.pid) : std::string("-"))
+            << std::setw(9) << c.utilization1s << std::setw(9) << c.utilization10s << c.busyTicks << "\n";
+    }
+    std::cout << out.str() << std::flush;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string name = "csopesy-stats";
+    int intervalMs = 200;
+    long count = 0;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string opt = argv[i];
+        if (opt == "-s") name = argv[i + 1];
+        else if (opt == "-i") intervalMs = std::stoi(argv[i + 1]);
+        else if (opt == "-n") count = std::stol(argv[i + 1]);
+        else {
+            std::cerr << "usage: csopesy-top [-s name] [-i ms] [-n count]\n";
+            return 1;
+        }
+    }
+
+    const StatsSegmentHeader* header = openSegment(name);
+    if (!header || std::memcmp(header->snapshot.magic, "CSSTATS1", 8) != 0 || header->snapshot.version != 1) {
+        std::cerr << "No emulator stats segment '" << name << "'; is the emulator initialized?\n";
+        return 1;
+    }
+
+    StatsSnapshot snap{};
+    std::vector<StatsCoreEntry> cores;
+    uint64_t retries = 0;
+    uint64_t lastPublishes = 0;
+    auto lastChange = std::chrono::steady_clock::now();
+    for (long shown = 0; count == 0 || shown < count; ++shown) {
+        readSnapshot(header, snap, cores, retries);   // on failure the last good snapshot is shown again
+        auto now = std::chrono::steady_clock::now();
+        if (snap.publishes != lastPublishes) {
+            lastPublishes = snap.publishes;
+            lastChange = now;
+        }
+        render(snap, cores, now - lastChange > std::chrono::seconds(1), retries);
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+    return 0;
+}
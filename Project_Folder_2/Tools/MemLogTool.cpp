@@ -0,0 +1,201 @@
+// MemLogTool.cpp
+// Offline reader for the binary memory event log written by MemoryManager.
+// Rebuilds the allocator layout at a tick or quantum and prints it in the
+// memory_stamp_XX.txt format.
+//
+//   memlog <memory_events.bin>                 layout after the last record
+//   memlog <memory_events.bin> --tick <T>      layout as of tick T
+//   memlog <memory_events.bin> --quantum <Q>   layout at quantum boundary Q
+//   memlog <memory_events.bin> --all           write memory_stamp_XX.txt for every quantum
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../Project_Folder_2/MemoryManager.h"
+#include "../Project_Folder_2/MemoryEventLog.h"
+
+namespace {
+
+struct LogFile {
+    MemoryLogHeader header{};
+    std::vector<MemoryEventRecord> records;
+};
+
+bool loadLog(const std::string& path, LogFile& log) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot open " << path << "\n";
+        return false;
+    }
+    in.read(reinterpret_cast<char*>(&log.header), sizeof(log.header));
+    if (!in || std::memcmp(log.header.magic, "CSMEMLOG", 8) != 0 || log.header.version != 1) {
+        std::cerr << path << " is not a memory event log\n";
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    std::streamoff bytes = static_cast<std::streamoff>(in.tellg()) - static_cast<std::streamoff>(sizeof(log.header));
+    in.seekg(sizeof(log.header), std::ios::beg);
+
+    // A torn final record (crash mid-write) is ignored
+    log.records.resize(static_cast<size_t>(bytes) / sizeof(MemoryEventRecord));
+    in.read(reinterpret_cast<char*>(log.records.data()), log.records.size() * sizeof(MemoryEventRecord));
+    return true;
+}
+
+// Allocated blocks keyed by start address
+using Layout = std::map<int, MemoryBlock>;
+
+void apply(Layout& layout, const MemoryEventRecord& rec) {
+    switch (static_cast<MemoryEventType>(rec.type)) {
+    case MemoryEventType::Allocate:
+    case MemoryEventType::Block:
+        layout[rec.start] = { rec.start, rec.end, rec.pid };
+        break;
+    case MemoryEventType::Free:
+        layout.erase(rec.start);
+        break;
+    case MemoryEventType::Checkpoint:
+        layout.clear();
+        break;
+    default:
+        break;
+    }
+}
+
+MemoryLogHeader g_header;
+
+// Adds the free range [from, to), split at shard boundaries as the manager keeps it
+void addHole(std::vector<MemoryBlock>& blocks, int from, int to) {
+    const MemoryLogHeader& h = g_header;
+    while (from < to) {
+        int shardEnd = to;
+        int shardSize = h.shardCount > 1 ? h.maxMemory / h.shardCount / h.memPerFrame * h.memPerFrame : 0;
+        if (shardSize > 0) {
+            int base = shardBaseOf(from, h.maxMemory, h.memPerFrame, h.shardCount);
+            bool last = base / shardSize == h.shardCount - 1;
+            if (!last) shardEnd = std::min(to, base + shardSize);
+        }
+        blocks.push_back({ from, shardEnd, -1 });
+        from = shardEnd;
+    }
+}
+
+// Expands the allocated set into the full block list, holes included
+std::vector<MemoryBlock> toBlocks(const Layout& layout, int maxMemory) {
+    std::vector<MemoryBlock> blocks;
+    int cursor = 0;
+    for (const auto& kv : layout) {
+        if (kv.second.start > cursor) addHole(blocks, cursor, kv.second.start);
+        blocks.push_back(kv.second);
+        cursor = kv.second.end;
+    }
+    if (cursor < maxMemory) addHole(blocks, cursor, maxMemory);
+    return blocks;
+}
+
+// Index of the first record with tick > t (records are appended in tick order)
+size_t upperBoundTick(const std::vector<MemoryEventRecord>& recs, uint64_t t) {
+    size_t lo = 0, hi = recs.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (recs[mid].tick <= t) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Layout after applying records [0, end), starting from the nearest checkpoint
+Layout layoutBefore(const std::vector<MemoryEventRecord>& recs, size_t end) {
+    size_t begin = end;
+    while (begin > 0 && recs[begin - 1].type != static_cast<uint8_t>(MemoryEventType::Checkpoint))
+        --begin;
+    if (begin > 0) --begin;
+
+    Layout layout;
+    for (size_t i = begin; i < end; ++i) apply(layout, recs[i]);
+    return layout;
+}
+
+time_t lastWallTime(const std::vector<MemoryEventRecord>& recs, size_t end) {
+    for (size_t i = end; i > 0; --i) {
+        if (recs[i - 1].wallTime != 0) return static_cast<time_t>(recs[i - 1].wallTime);
+    }
+    return time(nullptr);
+}
+
+void usage() {
+    std::cerr << "Usage: memlog <memory_events.bin> [--tick <T> | --quantum <Q> | --all]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+
+    LogFile log;
+    if (!loadLog(argv[1], log)) return 1;
+    g_header = log.header;
+    const auto& recs = log.records;
+    const int maxMemory = log.header.maxMemory;
+    const int memPerProc = log.header.memPerProc;
+
+    std::string mode = argc >= 3 ? argv[2] : "";
+
+    if (mode.empty()) {
+        Layout layout = layoutBefore(recs, recs.size());
+        renderMemoryStamp(std::cout, toBlocks(layout, maxMemory), maxMemory, memPerProc,
+            lastWallTime(recs, recs.size()));
+    }
+    else if (mode == "--tick" && argc >= 4) {
+        uint64_t tick = std::stoull(argv[3]);
+        size_t end = upperBoundTick(recs, tick);
+        Layout layout = layoutBefore(recs, end);
+        renderMemoryStamp(std::cout, toBlocks(layout, maxMemory), maxMemory, memPerProc,
+            lastWallTime(recs, end));
+    }
+    else if (mode == "--quantum" && argc >= 4) {
+        int quantum = std::stoi(argv[3]);
+        Layout layout;
+        for (const auto& rec : recs) {
+            if (rec.type == static_cast<uint8_t>(MemoryEventType::Quantum) && rec.pid == quantum) {
+                renderMemoryStamp(std::cout, toBlocks(layout, maxMemory), maxMemory, memPerProc,
+                    static_cast<time_t>(rec.wallTime));
+                return 0;
+            }
+            apply(layout, rec);
+        }
+        std::cerr << "Quantum " << quantum << " not found in log\n";
+        return 1;
+    }
+    else if (mode == "--all") {
+        Layout layout;
+        int written = 0;
+        for (const auto& rec : recs) {
+            if (rec.type == static_cast<uint8_t>(MemoryEventType::Quantum)) {
+                std::ostringstream filename;
+                filename << "memory_stamp_" << std::setw(2) << std::setfill('0') << rec.pid << ".txt";
+                std::ofstream out(filename.str());
+                renderMemoryStamp(out, toBlocks(layout, maxMemory), maxMemory, memPerProc,
+                    static_cast<time_t>(rec.wallTime));
+                written++;
+            }
+            apply(layout, rec);
+        }
+        std::cout << "Wrote " << written << " memory_stamp files\n";
+    }
+    else {
+        usage();
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+// TraceToChrome.cpp
+// Converts a binary scheduler trace written by trace-start/trace-stop into
+// Chrome trace JSON, which chrome://tracing and ui.perfetto.dev both load.
+// Each core gets a track of run slices (dispatch to quantum expiry, sleep or
+// finish); wakes and memory admission go on a separate scheduler track.
+//
+//   tracechrome <csopesy-trace.bin>               writes csopesy-trace.json
+//   tracechrome <csopesy-trace.bin> <out.json>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../Project_Folder_2/EventTracer.h"
+
+namespace {
+
+struct TraceFile {
+    TraceFileHeader header{};
+    std::vector<TraceEvent> events;
+};
+
+bool loadTrace(const std::string& path, TraceFile& trace) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Cannot open " << path << "\n";
+        return false;
+    }
+    in.read(reinterpret_cast<char*>(&trace.header), sizeof(trace.header));
+    if (!in || std::memcmp(trace.header.magic, "CSTRACE1", 8) != 0 || trace.header.version != 1) {
+        std::cerr << path << " is not a scheduler trace\n";
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    std::streamoff bytes = static_cast<std::streamoff>(in.tellg()) - static_cast<std::streamoff>(sizeof(trace.header));
+    in.seekg(sizeof(trace.header), std::ios::beg);
+    trace.events.resize(static_cast<size_t>(bytes) / sizeof(TraceEvent));
+    in.read(reinterpret_cast<char*>(trace.events.data()), trace.events.size() * sizeof(TraceEvent));
+
+    // Rings are drained one after another, so restore time order
+    std::stable_sort(trace.events.begin(), trace.events.end(),
+        [](const TraceEvent& a, const TraceEvent& b) { return a.nanos < b.nanos; });
+    return true;
+}
+
+// Chrome trace timestamps are in microseconds
+std::string micros(uint64_t nanos) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", nanos / 1000.0);
+    return buf;
+}
+
+const char* endReason(uint8_t type) {
+    switch (static_cast<TraceEventType>(type)) {
+    case TraceEventType::QuantumExpiry: return "quantum";
+    case TraceEventType::Sleep: return "sleep";
+    case TraceEventType::Finish: return "finish";
+    default: return "unknown";   // end event lost, or still running at trace-stop
+    }
+}
+
+class JsonWriter {
+public:
+    explicit JsonWriter(std::ostream& out) : out_(out) { out_ << "{\"traceEvents\":[\n"; }
+    ~JsonWriter() { out_ << "\n]}\n"; }
+
+    void event(const std::string& body) {
+        if (!first_) out_ << ",\n";
+        first_ = false;
+        out_ << "{" << body << "}";
+    }
+
+private:
+    std::ostream& out_;
+    bool first_ = true;
+};
+
+struct OpenSlice {
+    bool open = false;
+    TraceEvent start{};
+};
+
+void convert(const TraceFile& trace, std::ostream& out) {
+    uint32_t cores = trace.header.cores;
+    uint32_t schedulerTid = cores;
+    JsonWriter json(out);
+
+    json.event("\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CSOPESY scheduler\"}");
+    for (uint32_t c = 0; c < cores; ++c) {
+        json.event("\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(c) +
+            ",\"args\":{\"name\":\"Core " + std::to_string(c) + "\"}");
+    }
+    json.event("\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(schedulerTid) +
+        ",\"args\":{\"name\":\"Scheduler\"}");
+
+    std::vector<OpenSlice> slices(cores);
+    auto closeSlice = [&](uint32_t core, const TraceEvent& end) {
+        OpenSlice& s = slices[core];
+        if (!s.open) return;
+        s.open = false;
+        json.event("\"name\":\"p" + std::to_string(s.start.pid) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" +
+            std::to_string(core) + ",\"ts\":" + micros(s.start.nanos) + ",\"dur\":" +
+            micros(end.nanos - s.start.nanos) + ",\"args\":{\"start_tick\":" + std::to_string(s.start.tick) +
+            ",\"end_tick\":" + std::to_string(end.tick) + ",\"quantum\":" + std::to_string(s.start.arg) +
+            ",\"end\":\"" + endReason(end.type) + "\"}");
+    };
+    auto instant = [&](const TraceEvent& e, uint32_t tid, const std::string& name, const std::string& args) {
+        json.event("\"name\":\"" + name + "\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":" + std::to_string(tid) +
+            ",\"ts\":" + micros(e.nanos) + ",\"args\":{\"pid\":" + std::to_string(e.pid) + ",\"tick\":" +
+            std::to_string(e.tick) + args + "}");
+    };
+
+    for (const auto& e : trace.events) {
+        bool onCore = e.core != TraceNoCore && e.core < cores;
+        switch (static_cast<TraceEventType>(e.type)) {
+        case TraceEventType::Dispatch:
+            if (!onCore) break;
+            closeSlice(e.core, e);   // end event lost to a full ring
+            slices[e.core].open = true;
+            slices[e.core].start = e;
+            break;
+        case TraceEventType::Sleep:
+            if (!onCore) break;
+            closeSlice(e.core, e);
+            instant(e, e.core, "sleep p" + std::to_string(e.pid), ",\"sleep_ticks\":" + std::to_string(e.arg));
+            break;
+        case TraceEventType::QuantumExpiry:
+        case TraceEventType::Finish:
+            if (onCore) closeSlice(e.core, e);
+            break;
+        case TraceEventType::Wake:
+            instant(e, schedulerTid, "wake p" + std::to_string(e.pid), "");
+            break;
+        case TraceEventType::MemoryDefer:
+            instant(e, schedulerTid, "memory wait p" + std::to_string(e.pid), "");
+            break;
+        case TraceEventType::Admit:
+            instant(e, schedulerTid, "admit p" + std::to_string(e.pid), ",\"waited_ticks\":" + std::to_string(e.arg));
+            break;
+        }
+    }
+    // Slices still running when tracing stopped end at the last event
+    if (!trace.events.empty()) {
+        TraceEvent last = trace.events.back();
+        last.type = 0;
+        for (uint32_t c = 0; c < cores; ++c) closeSlice(c, last);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: tracechrome <csopesy-trace.bin> [out.json]\n";
+        return 1;
+    }
+    TraceFile trace;
+    if (!loadTrace(argv[1], trace)) return 1;
+
+    std::string outPath = argc >= 3 ? argv[2] : "csopesy-trace.json";
+    std::ofstream out(outPath);
+    if (!out) {
+        std::cerr << "Cannot create " << outPath << "\n";
+        return 1;
+    }
+    convert(trace, out);
+    std::cout << trace.events.size() << " events from " << trace.header.cores << " cores written to " << outPath << "\n";
+    return 0;
+}
@@ -1,10 +1,15 @@
 // ThreadedQueue.h
 // C++ implementation of the above approach
 #pragma once
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <iostream>
 #include <mutex>
 #include <queue>
+#include <vector>
+
+#include "ProfiledMutex.h"
 
 // Thread-safe queue
 template <typename T>
@@ -13,11 +18,14 @@ private:
     // Underlying queue
     std::queue<T> m_queue;
 
-    // mutex for thread synchronization
-    std::mutex m_mutex;
+    // mutex for thread synchronization; profiled under CSOPESY_LOCK_PROFILING
+    ProfiledMutex m_mutex{ "TSQueue::m_mutex" };
 
     // Condition variable for signaling
-    std::condition_variable m_cond;
+    ProfiledCondition m_cond;
+
+    // Number of times m_mutex was taken, for contention measurements
+    std::atomic<uint64_t> m_lockAcquisitions{ 0 };
 
 public:
     // Pushes an element to the queue
@@ -25,7 +33,8 @@ public:
     {
 
         // Acquire lock
-        std::unique_lock<std::mutex> lock(m_mutex);
+        ProfiledUniqueLock lock(m_mutex);
+        m_lockAcquisitions++;
 
         // Add item
         m_queue.push(item);
@@ -35,12 +44,26 @@ public:
         m_cond.notify_one();
     }
 
+    // Pushes all items, in order, under one lock acquisition
+    void push_many(std::vector<T>& items)
+    {
+        if (items.empty()) return;
+        ProfiledUniqueLock lock(m_mutex);
+        m_lockAcquisitions++;
+        for (auto& item : items) {
+            m_queue.push(std::move(item));
+        }
+        items.clear();
+        m_cond.notify_all();
+    }
+
     // Pops an element off the queue
     T pop()
     {
 
         // acquire lock
-        std::unique_lock<std::mutex> lock(m_mutex);
+        ProfiledUniqueLock lock(m_mutex);
+        m_lockAcquisitions++;
 
         // wait until queue is not empty
         m_cond.wait(lock,
@@ -56,7 +79,8 @@ public:
 
     // Non-blocking try_pop
     bool try_pop(T& item) {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        ProfiledUniqueLock lock(m_mutex);
+        m_lockAcquisitions++;
         if (m_queue.empty()) {
             return false;
         }
@@ -65,13 +89,33 @@ public:
         return true;
     }
 
+    // Non-blocking: appends up to maxItems elements to out under one lock
+    // acquisition and returns how many were taken
+    size_t pop_many(std::vector<T>& out, size_t maxItems) {
+        ProfiledUniqueLock lock(m_mutex);
+        m_lockAcquisitions++;
+        size_t taken = 0;
+        while (taken < maxItems && !m_queue.empty()) {
+            out.push_back(std::move(m_queue.front()));
+            m_queue.pop();
+            taken++;
+        }
+        return taken;
+    }
+
     bool empty() {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        ProfiledUniqueLock lock(m_mutex);
+        m_lockAcquisitions++;
         return m_queue.empty();
     }
 
     size_t size() {
-        std::unique_lock<std::mutex> lock(m_mutex);
+        ProfiledUniqueLock lock(m_mutex);
+        m_lockAcquisitions++;
         return m_queue.size();
     }
+
+    uint64_t lockAcquisitions() const {
+        return m_lockAcquisitions.load();
+    }
 };
\ No newline at end of file